@@ -9,248 +9,1359 @@ s32 tl_main(Span<String> args) {
 	StringBuilder function_declarations;
 	StringBuilder function_definitions;
 	StringBuilder function_prefix_strippers;
-	
+	StringBuilder form_enum;
+	StringBuilder encoders;
+	StringBuilder encoder_table;
+	StringBuilder form_infos;
+
 	#define hex(x) tformat("0x{}", format_hex(x))
 
+	// Every generated function belongs to one extension. Functions of each extension
+	// are emitted as a separate section, guarded by the corresponding macro, so clients
+	// can opt out of parsing instruction sets they don't use.
+	enum Extension {
+		ext_base,
+		ext_sse,
+		ext_avx,
+		ext_avx512,
+		ext_adx,
+		ext_bmi,
+		ext_fma,
+		ext_crypto,
+		ext_apx,
+		ext_count,
+	};
+
+	char const *extension_guards[ext_count] = {
+		"",
+		"X64W_EXT_SSE",
+		"X64W_EXT_AVX",
+		"X64W_EXT_AVX512",
+		"X64W_EXT_ADX",
+		"X64W_EXT_BMI",
+		"X64W_EXT_FMA",
+		"X64W_EXT_CRYPTO",
+		"X64W_EXT_APX",
+	};
+
+	struct Param {
+		char const *type;
+		char const *name;
+	};
+
+	// RFLAGS bits
+	enum : u16 {
+		CF = 0x0001,
+		PF = 0x0004,
+		AF = 0x0010,
+		ZF = 0x0040,
+		SF = 0x0080,
+		DF = 0x0400,
+		OF = 0x0800,
+		STATUS = CF | PF | AF | ZF | SF | OF,
+	};
+
+	// Implicitly accessed general purpose registers
+	enum : u16 {
+		RAX = 1 << 0,
+		RCX = 1 << 1,
+		RDX = 1 << 2,
+		RBX = 1 << 3,
+		RSP = 1 << 4,
+		RSI = 1 << 6,
+		RDI = 1 << 7,
+	};
+
+	// Implicitly accessed vector registers
+	enum : u16 {
+		XMM0 = 1 << 0,
+	};
+
+	// What the instruction does apart from encoding, exposed through x64w_form_info.
+	struct Effects {
+		// One letter per operand:
+		//     r - read
+		//     w - write
+		//     x - read and write
+		//     n - not accessed (address of lea)
+		char const *access;
+		u16 implicit_read;
+		u16 implicit_write;
+		u16 implicit_vector_read;
+		u16 implicit_vector_write;
+		u16 flags_read;
+		u16 flags_written;
+		u16 flags_undefined;
+	};
+
+	struct Form {
+		Extension extension;
+		u32 group;
+		char const *mnem;
+		Span<char> name;
+		StaticList<Param, 4> params;
+		Span<char> body;
+		Effects effects;
+	};
+
+	List<Form> forms;
+
+	// Section that following instructions are put into.
+	Extension extension = ext_base;
+
+	// Forms of one group are aligned with each other in the output.
+	u32 group = 0;
+
+	// Effects of following instructions.
+	Effects effects = {};
+
+	auto form = [&](char const *mnem, char const *suffix, std::initializer_list<Param> params, Span<char> body) {
+		Form f = {};
+		f.extension = extension;
+		f.group = group;
+		f.mnem = mnem;
+		f.name = suffix[0] ? format("{}_{}", mnem, suffix) : format("{}", mnem);
+		for (auto param : params) {
+			f.params.add(param);
+		}
+		f.body = body;
+		f.effects = effects;
+		forms.add(f);
+	};
+
 	// r/m, r/m/i
 	struct E1 {
 		u8 op[7];
 		u8 mod;
 	};
-	auto I1 = [&](char const *mnem, E1 e) {
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_ri8   (uint8_t **c, x64w_Gpr8  r, int8_t     i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_ri16  (uint8_t **c, x64w_Gpr16 r, int16_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_ri32  (uint8_t **c, x64w_Gpr32 r, int32_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r64i32(uint8_t **c, x64w_Gpr64 r, int32_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r16i8 (uint8_t **c, x64w_Gpr16 r, int8_t     i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r32i8 (uint8_t **c, x64w_Gpr32 r, int8_t     i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r64i8 (uint8_t **c, x64w_Gpr64 r, int8_t     i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rr8   (uint8_t **c, x64w_Gpr8  d, x64w_Gpr8  s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rr16  (uint8_t **c, x64w_Gpr16 d, x64w_Gpr16 s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rr32  (uint8_t **c, x64w_Gpr32 d, x64w_Gpr32 s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rr64  (uint8_t **c, x64w_Gpr64 d, x64w_Gpr64 s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm8   (uint8_t **c, x64w_Gpr8  d, x64w_Mem   s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm16  (uint8_t **c, x64w_Gpr16 d, x64w_Mem   s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm32  (uint8_t **c, x64w_Gpr32 d, x64w_Mem   s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm64  (uint8_t **c, x64w_Gpr64 d, x64w_Mem   s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mi8   (uint8_t **c, x64w_Mem   m, int8_t     i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mi16  (uint8_t **c, x64w_Mem   m, int16_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mi32  (uint8_t **c, x64w_Mem   m, int32_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m64i32(uint8_t **c, x64w_Mem   m, int32_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m16i8 (uint8_t **c, x64w_Mem   m, int16_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m32i8 (uint8_t **c, x64w_Mem   m, int32_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m64i8 (uint8_t **c, x64w_Mem   m, int32_t    i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mr8   (uint8_t **c, x64w_Mem   d, x64w_Gpr8  s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mr16  (uint8_t **c, x64w_Mem   d, x64w_Gpr16 s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mr32  (uint8_t **c, x64w_Mem   d, x64w_Gpr32 s);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mr64  (uint8_t **c, x64w_Mem   d, x64w_Gpr64 s);\n", mnem);
-		
-		append_format(function_definitions, "x64w_Result x64w_{}_ri8   (uint8_t **c, x64w_Gpr8  r, int8_t     i) {{ return instr_ri(c, r.i,   i, 1, {}, {},    0); }}\n", mnem, hex(e.op[0]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_ri16  (uint8_t **c, x64w_Gpr16 r, int16_t    i) {{ return instr_ri(c, r.i,   i, 2, {}, {},  OSO); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_ri32  (uint8_t **c, x64w_Gpr32 r, int32_t    i) {{ return instr_ri(c, r.i,   i, 4, {}, {},    0); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r64i32(uint8_t **c, x64w_Gpr64 r, int32_t    i) {{ return instr_ri(c, r.i,   i, 4, {}, {}, REXW); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r16i8 (uint8_t **c, x64w_Gpr16 r, int8_t     i) {{ return instr_ri(c, r.i,   i, 1, {}, {},  OSO); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r32i8 (uint8_t **c, x64w_Gpr32 r, int8_t     i) {{ return instr_ri(c, r.i,   i, 1, {}, {},    0); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r64i8 (uint8_t **c, x64w_Gpr64 r, int8_t     i) {{ return instr_ri(c, r.i,   i, 1, {}, {}, REXW); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_rr8   (uint8_t **c, x64w_Gpr8  d, x64w_Gpr8  s) {{ return instr_rr(c, d.i, s.i, 1, {}, \      0); }}\n", mnem, hex(e.op[5]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rr16  (uint8_t **c, x64w_Gpr16 d, x64w_Gpr16 s) {{ return instr_rr(c, d.i, s.i, 2, {}, \    OSO); }}\n", mnem, hex(e.op[6]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rr32  (uint8_t **c, x64w_Gpr32 d, x64w_Gpr32 s) {{ return instr_rr(c, d.i, s.i, 4, {}, \      0); }}\n", mnem, hex(e.op[6]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rr64  (uint8_t **c, x64w_Gpr64 d, x64w_Gpr64 s) {{ return instr_rr(c, d.i, s.i, 8, {}, \   REXW); }}\n", mnem, hex(e.op[6]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rm8   (uint8_t **c, x64w_Gpr8  d, x64w_Mem   s) {{ return instr_rm(c, d.i,   s, 1, {}, \      0); }}\n", mnem, hex(e.op[5]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rm16  (uint8_t **c, x64w_Gpr16 d, x64w_Mem   s) {{ return instr_rm(c, d.i,   s, 2, {}, \    OSO); }}\n", mnem, hex(e.op[6]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rm32  (uint8_t **c, x64w_Gpr32 d, x64w_Mem   s) {{ return instr_rm(c, d.i,   s, 4, {}, \      0); }}\n", mnem, hex(e.op[6]));
-		append_format(function_definitions, "x64w_Result x64w_{}_rm64  (uint8_t **c, x64w_Gpr64 d, x64w_Mem   s) {{ return instr_rm(c, d.i,   s, 8, {}, \   REXW); }}\n", mnem, hex(e.op[6]));
-		append_format(function_definitions, "x64w_Result x64w_{}_mi8   (uint8_t **c, x64w_Mem   m, int8_t     i) {{ return instr_mi(c,   m,   i, 1, {}, {},    0); }}\n", mnem, hex(e.op[0]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_mi16  (uint8_t **c, x64w_Mem   m, int16_t    i) {{ return instr_mi(c,   m,   i, 2, {}, {},  OSO); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_mi32  (uint8_t **c, x64w_Mem   m, int32_t    i) {{ return instr_mi(c,   m,   i, 4, {}, {},    0); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m64i32(uint8_t **c, x64w_Mem   m, int32_t    i) {{ return instr_mi(c,   m,   i, 4, {}, {}, REXW); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m16i8 (uint8_t **c, x64w_Mem   m, int16_t    i) {{ return instr_mi(c,   m,   i, 1, {}, {},  OSO); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m32i8 (uint8_t **c, x64w_Mem   m, int32_t    i) {{ return instr_mi(c,   m,   i, 1, {}, {},    0); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m64i8 (uint8_t **c, x64w_Mem   m, int32_t    i) {{ return instr_mi(c,   m,   i, 1, {}, {}, REXW); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_mr8   (uint8_t **c, x64w_Mem   d, x64w_Gpr8  s) {{ return instr_rm(c, s.i,   d, 1, {}, \      0); }}\n", mnem, hex(e.op[3]));
-		append_format(function_definitions, "x64w_Result x64w_{}_mr16  (uint8_t **c, x64w_Mem   d, x64w_Gpr16 s) {{ return instr_rm(c, s.i,   d, 2, {}, \    OSO); }}\n", mnem, hex(e.op[4]));
-		append_format(function_definitions, "x64w_Result x64w_{}_mr32  (uint8_t **c, x64w_Mem   d, x64w_Gpr32 s) {{ return instr_rm(c, s.i,   d, 4, {}, \      0); }}\n", mnem, hex(e.op[4]));
-		append_format(function_definitions, "x64w_Result x64w_{}_mr64  (uint8_t **c, x64w_Mem   d, x64w_Gpr64 s) {{ return instr_rm(c, s.i,   d, 8, {}, \   REXW); }}\n", mnem, hex(e.op[4]));
-		
-		append_format(function_prefix_strippers, "#define {}_ri8    x64w_{}_ri8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_ri16   x64w_{}_ri16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_ri32   x64w_{}_ri32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r64i32 x64w_{}_r64i32\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r16i8  x64w_{}_r16i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r32i8  x64w_{}_r32i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r64i8  x64w_{}_r64i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rr8    x64w_{}_rr8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rr16   x64w_{}_rr16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rr32   x64w_{}_rr32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rr64   x64w_{}_rr64  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rm8    x64w_{}_rm8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rm16   x64w_{}_rm16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rm32   x64w_{}_rm32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rm64   x64w_{}_rm64  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mi8    x64w_{}_mi8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mi16   x64w_{}_mi16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mi32   x64w_{}_mi32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m64i32 x64w_{}_m64i32\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m16i8  x64w_{}_m16i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m32i8  x64w_{}_m32i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m64i8  x64w_{}_m64i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mr8    x64w_{}_mr8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mr16   x64w_{}_mr16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mr32   x64w_{}_mr32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mr64   x64w_{}_mr64  \n", mnem, mnem);
-	};
-	
+	// `locked` names forms with lock prefix, they atomically modify the memory operand.
+	auto I1 = [&](char const *mnem, E1 e, Effects e2, char const *locked = 0) {
+		++group;
+		// Accumulator forms have no register operand.
+		Effects acc = e2;
+		acc.access = "r";
+		acc.implicit_read |= RAX;
+		if (e2.access[0] == 'x') {
+			acc.implicit_write |= RAX;
+		}
+		effects = acc;
+		form(mnem, "al_i8",   {{"int8_t",  "i"}}, tformat("instr_ri(c, 0, i, 1, 1, {}, 0, NO_MODRM)",        hex(e.op[3] + 4)));
+		form(mnem, "ax_i16",  {{"int16_t", "i"}}, tformat("instr_ri(c, 0, i, 2, 2, {}, 0, NO_MODRM | OSO)",  hex(e.op[3] + 5)));
+		form(mnem, "eax_i32", {{"int32_t", "i"}}, tformat("instr_ri(c, 0, i, 4, 4, {}, 0, NO_MODRM)",        hex(e.op[3] + 5)));
+		form(mnem, "rax_i32", {{"int32_t", "i"}}, tformat("instr_ri(c, 0, i, 8, 4, {}, 0, NO_MODRM | REXW)", hex(e.op[3] + 5)));
+		effects = e2;
+		form(mnem, "ri8",    {{"x64w_Gpr8",  "r"}, {"int8_t",     "i"}}, tformat("instr_ri(c, r.i,   i, 1, 1, {}, {},    0)", hex(e.op[0]), e.mod));
+		form(mnem, "ri16",   {{"x64w_Gpr16", "r"}, {"int16_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 2, 2, {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "ri32",   {{"x64w_Gpr32", "r"}, {"int32_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 4, 4, {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "r64i32", {{"x64w_Gpr64", "r"}, {"int32_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 8, 4, {}, {}, REXW)", hex(e.op[1]), e.mod));
+		form(mnem, "r16i8",  {{"x64w_Gpr16", "r"}, {"int8_t",     "i"}}, tformat("instr_ri(c, r.i,   i, 2, 1, {}, {},  OSO)", hex(e.op[2]), e.mod));
+		form(mnem, "r32i8",  {{"x64w_Gpr32", "r"}, {"int8_t",     "i"}}, tformat("instr_ri(c, r.i,   i, 4, 1, {}, {},    0)", hex(e.op[2]), e.mod));
+		form(mnem, "r64i8",  {{"x64w_Gpr64", "r"}, {"int8_t",     "i"}}, tformat("instr_ri(c, r.i,   i, 8, 1, {}, {}, REXW)", hex(e.op[2]), e.mod));
+		form(mnem, "rr8",    {{"x64w_Gpr8",  "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr(c, d.i, s.i, 1, {},       0)", hex(e.op[5])));
+		form(mnem, "rr16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, d.i, s.i, 2, {},     OSO)", hex(e.op[6])));
+		form(mnem, "rr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, {},       0)", hex(e.op[6])));
+		form(mnem, "rr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, {},    REXW)", hex(e.op[6])));
+		form(mnem, "rm8",    {{"x64w_Gpr8",  "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 1, {},       0)", hex(e.op[5])));
+		form(mnem, "rm16",   {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 2, {},     OSO)", hex(e.op[6])));
+		form(mnem, "rm32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, {},       0)", hex(e.op[6])));
+		form(mnem, "rm64",   {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, {},    REXW)", hex(e.op[6])));
+		form(mnem, "mi8",    {{"x64w_Mem",   "m"}, {"int8_t",     "i"}}, tformat("instr_mi(c,   m,   i, 1, {}, {},    0)", hex(e.op[0]), e.mod));
+		form(mnem, "mi16",   {{"x64w_Mem",   "m"}, {"int16_t",    "i"}}, tformat("instr_mi(c,   m,   i, 2, {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "mi32",   {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 4, {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "m64i32", {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 4, {}, {}, REXW)", hex(e.op[1]), e.mod));
+		form(mnem, "m16i8",  {{"x64w_Mem",   "m"}, {"int16_t",    "i"}}, tformat("instr_mi(c,   m,   i, 1, {}, {},  OSO)", hex(e.op[2]), e.mod));
+		form(mnem, "m32i8",  {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 1, {}, {},    0)", hex(e.op[2]), e.mod));
+		form(mnem, "m64i8",  {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 1, {}, {}, REXW)", hex(e.op[2]), e.mod));
+		form(mnem, "mr8",    {{"x64w_Mem",   "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i,   d, 1, {},       0)", hex(e.op[3])));
+		form(mnem, "mr16",   {{"x64w_Mem",   "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i,   d, 2, {},     OSO)", hex(e.op[4])));
+		form(mnem, "mr32",   {{"x64w_Mem",   "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i,   d, 4, {},       0)", hex(e.op[4])));
+		form(mnem, "mr64",   {{"x64w_Mem",   "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i,   d, 8, {},    REXW)", hex(e.op[4])));
+
+		if (!locked)
+			return;
+		++group;
+		form(locked, "mi8",    {{"x64w_Mem", "m"}, {"int8_t",     "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {}, LOCK)",        hex(e.op[0]), e.mod));
+		form(locked, "mi16",   {{"x64w_Mem", "m"}, {"int16_t",    "i"}}, tformat("instr_mi(c,   m, i, 2, {}, {}, LOCK | OSO)",  hex(e.op[1]), e.mod));
+		form(locked, "mi32",   {{"x64w_Mem", "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m, i, 4, {}, {}, LOCK)",        hex(e.op[1]), e.mod));
+		form(locked, "m64i32", {{"x64w_Mem", "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m, i, 4, {}, {}, LOCK | REXW)", hex(e.op[1]), e.mod));
+		form(locked, "m16i8",  {{"x64w_Mem", "m"}, {"int16_t",    "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {}, LOCK | OSO)",  hex(e.op[2]), e.mod));
+		form(locked, "m32i8",  {{"x64w_Mem", "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {}, LOCK)",        hex(e.op[2]), e.mod));
+		form(locked, "m64i8",  {{"x64w_Mem", "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {}, LOCK | REXW)", hex(e.op[2]), e.mod));
+		form(locked, "mr8",    {{"x64w_Mem", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i, d, 1, {},     LOCK)",        hex(e.op[3])));
+		form(locked, "mr16",   {{"x64w_Mem", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i, d, 2, {},     LOCK | OSO)",  hex(e.op[4])));
+		form(locked, "mr32",   {{"x64w_Mem", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i, d, 4, {},     LOCK)",        hex(e.op[4])));
+		form(locked, "mr64",   {{"x64w_Mem", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i, d, 8, {},     LOCK | REXW)", hex(e.op[4])));
+	};
+
+	// APX new data destination forms of I1, first register receives the result.
+	auto I1_ndd = [&](char const *mnem, E1 e, Effects e2) {
+		++group;
+		effects = e2;
+		effects.access = "wrr";
+		form(mnem, "rrr16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "a"}, {"x64w_Gpr16", "b"}}, tformat("instr_ndd_rr(c, d.i, b.i, a.i, {},     OSO)", hex(e.op[4])));
+		form(mnem, "rrr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Gpr32", "b"}}, tformat("instr_ndd_rr(c, d.i, b.i, a.i, {},       0)", hex(e.op[4])));
+		form(mnem, "rrr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Gpr64", "b"}}, tformat("instr_ndd_rr(c, d.i, b.i, a.i, {},    REXW)", hex(e.op[4])));
+		form(mnem, "rrm16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_ndd_rm(c, d.i, a.i,   b, {},     OSO)", hex(e.op[6])));
+		form(mnem, "rrm32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_ndd_rm(c, d.i, a.i,   b, {},       0)", hex(e.op[6])));
+		form(mnem, "rrm64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_ndd_rm(c, d.i, a.i,   b, {},    REXW)", hex(e.op[6])));
+		form(mnem, "rmr16",   {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "a"}, {"x64w_Gpr16", "b"}}, tformat("instr_ndd_rm(c, d.i, b.i,   a, {},     OSO)", hex(e.op[4])));
+		form(mnem, "rmr32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "a"}, {"x64w_Gpr32", "b"}}, tformat("instr_ndd_rm(c, d.i, b.i,   a, {},       0)", hex(e.op[4])));
+		form(mnem, "rmr64",   {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "a"}, {"x64w_Gpr64", "b"}}, tformat("instr_ndd_rm(c, d.i, b.i,   a, {},    REXW)", hex(e.op[4])));
+		form(mnem, "rri16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "a"}, {"int16_t",    "i"}}, tformat("instr_ndd_ri(c, d.i, a.i, i, 2, {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "rri32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"int32_t",    "i"}}, tformat("instr_ndd_ri(c, d.i, a.i, i, 4, {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "rr64i32", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"int32_t",    "i"}}, tformat("instr_ndd_ri(c, d.i, a.i, i, 4, {}, {}, REXW)", hex(e.op[1]), e.mod));
+		form(mnem, "rr16i8",  {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "a"}, {"int8_t",     "i"}}, tformat("instr_ndd_ri(c, d.i, a.i, i, 1, {}, {},  OSO)", hex(e.op[2]), e.mod));
+		form(mnem, "rr32i8",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"int8_t",     "i"}}, tformat("instr_ndd_ri(c, d.i, a.i, i, 1, {}, {},    0)", hex(e.op[2]), e.mod));
+		form(mnem, "rr64i8",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"int8_t",     "i"}}, tformat("instr_ndd_ri(c, d.i, a.i, i, 1, {}, {}, REXW)", hex(e.op[2]), e.mod));
+		form(mnem, "rmi16",   {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "a"}, {"int16_t",    "i"}}, tformat("instr_ndd_mi(c, d.i,   a, i, 2, {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "rmi32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "a"}, {"int32_t",    "i"}}, tformat("instr_ndd_mi(c, d.i,   a, i, 4, {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "rm64i32", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "a"}, {"int32_t",    "i"}}, tformat("instr_ndd_mi(c, d.i,   a, i, 4, {}, {}, REXW)", hex(e.op[1]), e.mod));
+		form(mnem, "rm16i8",  {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "a"}, {"int8_t",     "i"}}, tformat("instr_ndd_mi(c, d.i,   a, i, 1, {}, {},  OSO)", hex(e.op[2]), e.mod));
+		form(mnem, "rm32i8",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "a"}, {"int8_t",     "i"}}, tformat("instr_ndd_mi(c, d.i,   a, i, 1, {}, {},    0)", hex(e.op[2]), e.mod));
+		form(mnem, "rm64i8",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "a"}, {"int8_t",     "i"}}, tformat("instr_ndd_mi(c, d.i,   a, i, 1, {}, {}, REXW)", hex(e.op[2]), e.mod));
+	};
+
 	// r/m
 	struct E2 {
 		u8 op[2];
 		u8 mod;
 	};
-	auto I2 = [&](char const *mnem, E2 e) {
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r8   (uint8_t **c, x64w_Gpr8  d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r16  (uint8_t **c, x64w_Gpr16 d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r32  (uint8_t **c, x64w_Gpr32 d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r64  (uint8_t **c, x64w_Gpr64 d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m8   (uint8_t **c, x64w_Mem   d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m16  (uint8_t **c, x64w_Mem   d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m32  (uint8_t **c, x64w_Mem   d);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m64  (uint8_t **c, x64w_Mem   d);\n", mnem);
-		
-		append_format(function_definitions, "x64w_Result x64w_{}_r8 (uint8_t **c, x64w_Gpr8  d) {{ return instr_r(c, d.i, 1, {}, {},    0); }}\n", mnem, hex(e.op[0]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r16(uint8_t **c, x64w_Gpr16 d) {{ return instr_r(c, d.i, 2, {}, {},  OSO); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r32(uint8_t **c, x64w_Gpr32 d) {{ return instr_r(c, d.i, 4, {}, {},    0); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r64(uint8_t **c, x64w_Gpr64 d) {{ return instr_r(c, d.i, 8, {}, {}, REXW); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m8 (uint8_t **c, x64w_Mem   d) {{ return instr_m(c,   d,    {}, {},    0); }}\n", mnem, hex(e.op[0]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m16(uint8_t **c, x64w_Mem   d) {{ return instr_m(c,   d,    {}, {},  OSO); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m32(uint8_t **c, x64w_Mem   d) {{ return instr_m(c,   d,    {}, {},    0); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m64(uint8_t **c, x64w_Mem   d) {{ return instr_m(c,   d,    {}, {}, REXW); }}\n", mnem, hex(e.op[1]), e.mod);
-		
-		append_format(function_prefix_strippers, "#define {}_r8  x64w_{}_r8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r16 x64w_{}_r16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r32 x64w_{}_r32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r64 x64w_{}_r64  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m8  x64w_{}_m8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m16 x64w_{}_m16  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m32 x64w_{}_m32  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m64 x64w_{}_m64  \n", mnem, mnem);
-	};
-	
+	auto I2 = [&](char const *mnem, E2 e, Effects e2, char const *locked = 0) {
+		++group;
+		// Byte forms of mul and div use ax instead of rdx:rax.
+		Effects e8 = e2;
+		e8.implicit_read  &= ~RDX;
+		e8.implicit_write &= ~RDX;
+		effects = e8;
+		form(mnem, "r8",  {{"x64w_Gpr8",  "d"}}, tformat("instr_r(c, d.i, 1, {}, {},    0)", hex(e.op[0]), e.mod));
+		effects = e2;
+		form(mnem, "r16", {{"x64w_Gpr16", "d"}}, tformat("instr_r(c, d.i, 2, {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "r32", {{"x64w_Gpr32", "d"}}, tformat("instr_r(c, d.i, 4, {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "r64", {{"x64w_Gpr64", "d"}}, tformat("instr_r(c, d.i, 8, {}, {}, REXW)", hex(e.op[1]), e.mod));
+		effects = e8;
+		form(mnem, "m8",  {{"x64w_Mem",   "d"}}, tformat("instr_m(c,   d,    {}, {},    0)", hex(e.op[0]), e.mod));
+		effects = e2;
+		form(mnem, "m16", {{"x64w_Mem",   "d"}}, tformat("instr_m(c,   d,    {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "m32", {{"x64w_Mem",   "d"}}, tformat("instr_m(c,   d,    {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "m64", {{"x64w_Mem",   "d"}}, tformat("instr_m(c,   d,    {}, {}, REXW)", hex(e.op[1]), e.mod));
+
+		if (!locked)
+			return;
+		++group;
+		form(locked, "m8",  {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, {}, {}, LOCK)",        hex(e.op[0]), e.mod));
+		form(locked, "m16", {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, {}, {}, LOCK | OSO)",  hex(e.op[1]), e.mod));
+		form(locked, "m32", {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, {}, {}, LOCK)",        hex(e.op[1]), e.mod));
+		form(locked, "m64", {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, {}, {}, LOCK | REXW)", hex(e.op[1]), e.mod));
+	};
+
 	// r/m, i8/cl/1
 	struct E3 {
 		u8 op[6];
 		u8 mod;
 	};
-	auto I3 = [&](char const *mnem, E3 e) {
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r8_1  (uint8_t **c, x64w_Gpr8  r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r16_1 (uint8_t **c, x64w_Gpr16 r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r32_1 (uint8_t **c, x64w_Gpr32 r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r64_1 (uint8_t **c, x64w_Gpr64 r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_ri8   (uint8_t **c, x64w_Gpr8  r, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r16i8 (uint8_t **c, x64w_Gpr16 r, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r32i8 (uint8_t **c, x64w_Gpr32 r, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r64i8 (uint8_t **c, x64w_Gpr64 r, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r8_cl (uint8_t **c, x64w_Gpr8  r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r16_cl(uint8_t **c, x64w_Gpr16 r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r32_cl(uint8_t **c, x64w_Gpr32 r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_r64_cl(uint8_t **c, x64w_Gpr64 r           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m8_1  (uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m16_1 (uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m32_1 (uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m64_1 (uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_mi8   (uint8_t **c, x64w_Mem   m, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m16i8 (uint8_t **c, x64w_Mem   m, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m32i8 (uint8_t **c, x64w_Mem   m, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m64i8 (uint8_t **c, x64w_Mem   m, uint8_t i);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m8_cl (uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m16_cl(uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m32_cl(uint8_t **c, x64w_Mem   m           );\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_m64_cl(uint8_t **c, x64w_Mem   m           );\n", mnem);
-		
-		append_format(function_definitions, "x64w_Result x64w_{}_r8_1  (uint8_t **c, x64w_Gpr8  r           ) {{ return instr_r (c, r.i,    1, {}, {},    0); }}\n", mnem, hex(e.op[0]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r16_1 (uint8_t **c, x64w_Gpr16 r           ) {{ return instr_r (c, r.i,    2, {}, {},  OSO); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r32_1 (uint8_t **c, x64w_Gpr32 r           ) {{ return instr_r (c, r.i,    4, {}, {},    0); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r64_1 (uint8_t **c, x64w_Gpr64 r           ) {{ return instr_r (c, r.i,    8, {}, {}, REXW); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_ri8   (uint8_t **c, x64w_Gpr8  r, uint8_t i) {{ return instr_ri(c, r.i, i, 1, {}, {},    0); }}\n", mnem, hex(e.op[4]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r16i8 (uint8_t **c, x64w_Gpr16 r, uint8_t i) {{ return instr_ri(c, r.i, i, 1, {}, {},  OSO); }}\n", mnem, hex(e.op[5]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r32i8 (uint8_t **c, x64w_Gpr32 r, uint8_t i) {{ return instr_ri(c, r.i, i, 1, {}, {},    0); }}\n", mnem, hex(e.op[5]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r64i8 (uint8_t **c, x64w_Gpr64 r, uint8_t i) {{ return instr_ri(c, r.i, i, 1, {}, {}, REXW); }}\n", mnem, hex(e.op[5]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r8_cl (uint8_t **c, x64w_Gpr8  r           ) {{ return instr_r (c, r.i,    1, {}, {},    0); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r16_cl(uint8_t **c, x64w_Gpr16 r           ) {{ return instr_r (c, r.i,    2, {}, {},  OSO); }}\n", mnem, hex(e.op[3]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r32_cl(uint8_t **c, x64w_Gpr32 r           ) {{ return instr_r (c, r.i,    4, {}, {},    0); }}\n", mnem, hex(e.op[3]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_r64_cl(uint8_t **c, x64w_Gpr64 r           ) {{ return instr_r (c, r.i,    8, {}, {}, REXW); }}\n", mnem, hex(e.op[3]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m8_1  (uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {},    0); }}\n", mnem, hex(e.op[0]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m16_1 (uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {},  OSO); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m32_1 (uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {},    0); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m64_1 (uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {}, REXW); }}\n", mnem, hex(e.op[1]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_mi8   (uint8_t **c, x64w_Mem   m, uint8_t i) {{ return instr_mi(c,   m, i, 1, {}, {},    0); }}\n", mnem, hex(e.op[4]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m16i8 (uint8_t **c, x64w_Mem   m, uint8_t i) {{ return instr_mi(c,   m, i, 1, {}, {},  OSO); }}\n", mnem, hex(e.op[5]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m32i8 (uint8_t **c, x64w_Mem   m, uint8_t i) {{ return instr_mi(c,   m, i, 1, {}, {},    0); }}\n", mnem, hex(e.op[5]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m64i8 (uint8_t **c, x64w_Mem   m, uint8_t i) {{ return instr_mi(c,   m, i, 1, {}, {}, REXW); }}\n", mnem, hex(e.op[5]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m8_cl (uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {},    0); }}\n", mnem, hex(e.op[2]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m16_cl(uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {},  OSO); }}\n", mnem, hex(e.op[3]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m32_cl(uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {},    0); }}\n", mnem, hex(e.op[3]), e.mod);
-		append_format(function_definitions, "x64w_Result x64w_{}_m64_cl(uint8_t **c, x64w_Mem   m           ) {{ return instr_m (c,   m,       {}, {}, REXW); }}\n", mnem, hex(e.op[3]), e.mod);
-		
-		append_format(function_prefix_strippers, "#define {}_r8_1   x64w_{}_r8_1  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r16_1  x64w_{}_r16_1 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r32_1  x64w_{}_r32_1 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r64_1  x64w_{}_r64_1 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_ri8    x64w_{}_ri8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r16i8  x64w_{}_r16i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r32i8  x64w_{}_r32i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r64i8  x64w_{}_r64i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r8_cl  x64w_{}_r8_cl \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r16_cl x64w_{}_r16_cl\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r32_cl x64w_{}_r32_cl\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_r64_cl x64w_{}_r64_cl\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m8_1   x64w_{}_m8_1  \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m16_1  x64w_{}_m16_1 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m32_1  x64w_{}_m32_1 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m64_1  x64w_{}_m64_1 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_mi8    x64w_{}_mi8   \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m16i8  x64w_{}_m16i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m32i8  x64w_{}_m32i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m64i8  x64w_{}_m64i8 \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m8_cl  x64w_{}_m8_cl \n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m16_cl x64w_{}_m16_cl\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m32_cl x64w_{}_m32_cl\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_m64_cl x64w_{}_m64_cl\n", mnem, mnem);
-	};
-	
+	auto I3 = [&](char const *mnem, E3 e, Effects e2) {
+		++group;
+		// OF is defined only for shifts by 1. Shifts by zero don't modify flags,
+		// so with a variable count previous values may survive: they are read too.
+		Effects by_1 = e2;
+		Effects by_i8 = e2;
+		by_i8.flags_written   &= ~OF;
+		by_i8.flags_undefined |= OF;
+		by_i8.flags_read      |= by_i8.flags_written | by_i8.flags_undefined;
+		Effects by_cl = by_i8;
+		by_cl.implicit_read |= RCX;
+		effects = by_1;
+		form(mnem, "r8_1",   {{"x64w_Gpr8",  "r"}},                  tformat("instr_r (c, r.i,    1, {}, {},    0)", hex(e.op[0]), e.mod));
+		form(mnem, "r16_1",  {{"x64w_Gpr16", "r"}},                  tformat("instr_r (c, r.i,    2, {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "r32_1",  {{"x64w_Gpr32", "r"}},                  tformat("instr_r (c, r.i,    4, {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "r64_1",  {{"x64w_Gpr64", "r"}},                  tformat("instr_r (c, r.i,    8, {}, {}, REXW)", hex(e.op[1]), e.mod));
+		effects = by_i8;
+		form(mnem, "ri8",    {{"x64w_Gpr8",  "r"}, {"uint8_t", "i"}}, tformat("instr_ri(c, r.i, i, 1, 1, {}, {},    0)", hex(e.op[4]), e.mod));
+		form(mnem, "r16i8",  {{"x64w_Gpr16", "r"}, {"uint8_t", "i"}}, tformat("instr_ri(c, r.i, i, 2, 1, {}, {},  OSO)", hex(e.op[5]), e.mod));
+		form(mnem, "r32i8",  {{"x64w_Gpr32", "r"}, {"uint8_t", "i"}}, tformat("instr_ri(c, r.i, i, 4, 1, {}, {},    0)", hex(e.op[5]), e.mod));
+		form(mnem, "r64i8",  {{"x64w_Gpr64", "r"}, {"uint8_t", "i"}}, tformat("instr_ri(c, r.i, i, 8, 1, {}, {}, REXW)", hex(e.op[5]), e.mod));
+		effects = by_cl;
+		form(mnem, "r8_cl",  {{"x64w_Gpr8",  "r"}},                  tformat("instr_r (c, r.i,    1, {}, {},    0)", hex(e.op[2]), e.mod));
+		form(mnem, "r16_cl", {{"x64w_Gpr16", "r"}},                  tformat("instr_r (c, r.i,    2, {}, {},  OSO)", hex(e.op[3]), e.mod));
+		form(mnem, "r32_cl", {{"x64w_Gpr32", "r"}},                  tformat("instr_r (c, r.i,    4, {}, {},    0)", hex(e.op[3]), e.mod));
+		form(mnem, "r64_cl", {{"x64w_Gpr64", "r"}},                  tformat("instr_r (c, r.i,    8, {}, {}, REXW)", hex(e.op[3]), e.mod));
+		effects = by_1;
+		form(mnem, "m8_1",   {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {},    0)", hex(e.op[0]), e.mod));
+		form(mnem, "m16_1",  {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {},  OSO)", hex(e.op[1]), e.mod));
+		form(mnem, "m32_1",  {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {},    0)", hex(e.op[1]), e.mod));
+		form(mnem, "m64_1",  {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {}, REXW)", hex(e.op[1]), e.mod));
+		effects = by_i8;
+		form(mnem, "mi8",    {{"x64w_Mem",   "m"}, {"uint8_t", "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {},    0)", hex(e.op[4]), e.mod));
+		form(mnem, "m16i8",  {{"x64w_Mem",   "m"}, {"uint8_t", "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {},  OSO)", hex(e.op[5]), e.mod));
+		form(mnem, "m32i8",  {{"x64w_Mem",   "m"}, {"uint8_t", "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {},    0)", hex(e.op[5]), e.mod));
+		form(mnem, "m64i8",  {{"x64w_Mem",   "m"}, {"uint8_t", "i"}}, tformat("instr_mi(c,   m, i, 1, {}, {}, REXW)", hex(e.op[5]), e.mod));
+		effects = by_cl;
+		form(mnem, "m8_cl",  {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {},    0)", hex(e.op[2]), e.mod));
+		form(mnem, "m16_cl", {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {},  OSO)", hex(e.op[3]), e.mod));
+		form(mnem, "m32_cl", {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {},    0)", hex(e.op[3]), e.mod));
+		form(mnem, "m64_cl", {{"x64w_Mem",   "m"}},                  tformat("instr_m (c,   m,       {}, {}, REXW)", hex(e.op[3]), e.mod));
+	};
+
 	// r, m
 	struct E4 {
 		u8 op;
 	};
-	auto I4 = [&](char const *mnem, E4 e) {
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm16(uint8_t **c, x64w_Gpr16 r, x64w_Mem m);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm32(uint8_t **c, x64w_Gpr32 r, x64w_Mem m);\n", mnem);
-		append_format(function_declarations, "X64W_DEF x64w_Result x64w_{}_rm64(uint8_t **c, x64w_Gpr64 r, x64w_Mem m);\n", mnem);
-		
-		append_format(function_definitions, "x64w_Result x64w_{}_rm16(uint8_t **c, x64w_Gpr16 r, x64w_Mem m) {{ return instr_rm(c, r.i, m, 2, {},  OSO); }}\n", mnem, hex(e.op));
-		append_format(function_definitions, "x64w_Result x64w_{}_rm32(uint8_t **c, x64w_Gpr32 r, x64w_Mem m) {{ return instr_rm(c, r.i, m, 4, {},    0); }}\n", mnem, hex(e.op));
-		append_format(function_definitions, "x64w_Result x64w_{}_rm64(uint8_t **c, x64w_Gpr64 r, x64w_Mem m) {{ return instr_rm(c, r.i, m, 8, {}, REXW); }}\n", mnem, hex(e.op));
-		
-		append_format(function_prefix_strippers, "#define {}_rm16 x64w_{}_rm16\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rm32 x64w_{}_rm32\n", mnem, mnem);
-		append_format(function_prefix_strippers, "#define {}_rm64 x64w_{}_rm64\n", mnem, mnem);
-	};
-
-	I1("adc", {.op = {0x80, 0x81, 0x83, 0x10, 0x11, 0x12, 0x13}, .mod = 2,});
-	I1("add", {.op = {0x80, 0x81, 0x83, 0x00, 0x01, 0x02, 0x03}, .mod = 0,});
-	I1("xor", {.op = {0x80, 0x81, 0x83, 0x30, 0x31, 0x32, 0x33}, .mod = 6,});
-	I1("and", {.op = {0x80, 0x81, 0x83, 0x20, 0x21, 0x22, 0x23}, .mod = 4,});
-	I1("or",  {.op = {0x80, 0x81, 0x83, 0x08, 0x09, 0x0a, 0x0b}, .mod = 1,});
-	I1("sub", {.op = {0x80, 0x81, 0x83, 0x28, 0x29, 0x2a, 0x2b}, .mod = 5,});
-	I2("inc", {.op = {0xfe, 0xff}, .mod = 0});
-	I2("dec", {.op = {0xfe, 0xff}, .mod = 1});
-	I2("not", {.op = {0xf6, 0xf7}, .mod = 2});
-	I2("neg", {.op = {0xf6, 0xf7}, .mod = 3});
-	I2("mul", {.op = {0xf6, 0xf7}, .mod = 4});
-	I2("div", {.op = {0xf6, 0xf7}, .mod = 6});
-	I3("shl", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 4});
-	I3("shr", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 5});
-	I3("sal", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 4});
-	I3("sar", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 7});
-	I4("lea", {.op = 0x8d});
+	auto I4 = [&](char const *mnem, E4 e, Effects e2) {
+		++group;
+		effects = e2;
+		form(mnem, "rm16", {{"x64w_Gpr16", "r"}, {"x64w_Mem", "m"}}, tformat("instr_rm(c, r.i, m, 2, {},  OSO)", hex(e.op)));
+		form(mnem, "rm32", {{"x64w_Gpr32", "r"}, {"x64w_Mem", "m"}}, tformat("instr_rm(c, r.i, m, 4, {},    0)", hex(e.op)));
+		form(mnem, "rm64", {{"x64w_Gpr64", "r"}, {"x64w_Mem", "m"}}, tformat("instr_rm(c, r.i, m, 8, {}, REXW)", hex(e.op)));
+	};
+
+	++group;
+	effects = {.access = "r", .implicit_read = RSP, .implicit_write = RSP};
+	form("push", "i8",  {{"int8_t",     "i"}}, tformat("instr_i1(c,   i,    0x6a)"));
+	form("push", "i32", {{"int32_t",    "i"}}, tformat("instr_i4(c,   i,    0x68)"));
+	form("push", "r16", {{"x64w_Gpr16", "s"}}, tformat("instr_r (c, s.i, 2, 0x50, 0, NO_MODRM | OSO)"));
+	form("push", "r64", {{"x64w_Gpr64", "s"}}, tformat("instr_r (c, s.i, 8, 0x50, 0, NO_MODRM)"));
+	form("push", "m16", {{"x64w_Mem",   "d"}}, tformat("instr_m (c,   d,    0xff, 6, OSO)"));
+	form("push", "m64", {{"x64w_Mem",   "d"}}, tformat("instr_m (c,   d,    0xff, 6, 0)"));
+
+	++group;
+	effects = {.access = "w", .implicit_read = RSP, .implicit_write = RSP};
+	form("pop", "r16", {{"x64w_Gpr16", "s"}}, tformat("instr_r(c, s.i, 2, 0x58, 0, NO_MODRM | OSO)"));
+	form("pop", "r64", {{"x64w_Gpr64", "s"}}, tformat("instr_r(c, s.i, 8, 0x58, 0, NO_MODRM)"));
+	form("pop", "m16", {{"x64w_Mem",   "d"}}, tformat("instr_m(c,   d,    0x8f, 0, OSO)"));
+	form("pop", "m64", {{"x64w_Mem",   "d"}}, tformat("instr_m(c,   d,    0x8f, 0, 0)"));
+
+	++group;
+	effects = {.access = "wr"};
+	form("mov", "ri8",    {{"x64w_Gpr8",  "r"}, {"int8_t",     "i"}}, tformat("instr_ri(c, r.i,   i, 1, 1, 0xb0, 0, NO_MODRM)"));
+	form("mov", "ri16",   {{"x64w_Gpr16", "r"}, {"int16_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 2, 2, 0xb8, 0, NO_MODRM | OSO)"));
+	form("mov", "ri32",   {{"x64w_Gpr32", "r"}, {"int32_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 4, 4, 0xb8, 0, NO_MODRM)"));
+	form("mov", "ri64",   {{"x64w_Gpr64", "r"}, {"int64_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 8, 8, 0xb8, 0, NO_MODRM | REXW)"));
+	form("mov", "rr8",    {{"x64w_Gpr8",  "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr(c, d.i, s.i, 1, 0x8a, 0)"));
+	form("mov", "rr16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, d.i, s.i, 2, 0x8b, OSO)"));
+	form("mov", "rr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, 0x8b, 0)"));
+	form("mov", "rr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, 0x8b, REXW)"));
+	form("mov", "rm8",    {{"x64w_Gpr8",  "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 1, 0x8a, 0)"));
+	form("mov", "rm16",   {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 2, 0x8b, OSO)"));
+	form("mov", "rm32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, 0x8b, 0)"));
+	form("mov", "rm64",   {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, 0x8b, REXW)"));
+	form("mov", "mr8",    {{"x64w_Mem",   "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i,   d, 1, 0x88, 0)"));
+	form("mov", "mr16",   {{"x64w_Mem",   "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i,   d, 2, 0x89, OSO)"));
+	form("mov", "mr32",   {{"x64w_Mem",   "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i,   d, 4, 0x89, 0)"));
+	form("mov", "mr64",   {{"x64w_Mem",   "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i,   d, 8, 0x89, REXW)"));
+	form("mov", "mi8",    {{"x64w_Mem",   "m"}, {"int8_t",     "i"}}, tformat("instr_mi(c,   m,   i, 1, 0xc6, 0, 0)"));
+	form("mov", "mi16",   {{"x64w_Mem",   "m"}, {"int16_t",    "i"}}, tformat("instr_mi(c,   m,   i, 2, 0xc7, 0, OSO)"));
+	form("mov", "mi32",   {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 4, 0xc7, 0, 0)"));
+	form("mov", "m64i32", {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 4, 0xc7, 0, REXW)"));
+
+	++group;
+	effects = {.access = "rr", .flags_written = STATUS & ~AF, .flags_undefined = AF};
+	form("test", "ri8",    {{"x64w_Gpr8",  "r"}, {"int8_t",     "i"}}, tformat("instr_ri(c, r.i,   i, 1, 1, 0xf6, 0, 0)"));
+	form("test", "ri16",   {{"x64w_Gpr16", "r"}, {"int16_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 2, 2, 0xf7, 0, OSO)"));
+	form("test", "ri32",   {{"x64w_Gpr32", "r"}, {"int32_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 4, 4, 0xf7, 0, 0)"));
+	form("test", "r64i32", {{"x64w_Gpr64", "r"}, {"int32_t",    "i"}}, tformat("instr_ri(c, r.i,   i, 8, 4, 0xf7, 0, REXW)"));
+	form("test", "rr8",    {{"x64w_Gpr8",  "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr(c, s.i, d.i, 1, 0x84, 0)"));
+	form("test", "rr16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, s.i, d.i, 2, 0x85, OSO)"));
+	form("test", "rr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, s.i, d.i, 4, 0x85, 0)"));
+	form("test", "rr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, s.i, d.i, 8, 0x85, REXW)"));
+	form("test", "mr8",    {{"x64w_Mem",   "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i,   d, 1, 0x84, 0)"));
+	form("test", "mr16",   {{"x64w_Mem",   "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i,   d, 2, 0x85, OSO)"));
+	form("test", "mr32",   {{"x64w_Mem",   "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i,   d, 4, 0x85, 0)"));
+	form("test", "mr64",   {{"x64w_Mem",   "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i,   d, 8, 0x85, REXW)"));
+	form("test", "mi8",    {{"x64w_Mem",   "m"}, {"int8_t",     "i"}}, tformat("instr_mi(c,   m,   i, 1, 0xf6, 0, 0)"));
+	form("test", "mi16",   {{"x64w_Mem",   "m"}, {"int16_t",    "i"}}, tformat("instr_mi(c,   m,   i, 2, 0xf7, 0, OSO)"));
+	form("test", "mi32",   {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 4, 0xf7, 0, 0)"));
+	form("test", "m64i32", {{"x64w_Mem",   "m"}, {"int32_t",    "i"}}, tformat("instr_mi(c,   m,   i, 4, 0xf7, 0, REXW)"));
+	effects = {.access = "r", .implicit_read = RAX, .flags_written = STATUS & ~AF, .flags_undefined = AF};
+	form("test", "al_i8",   {{"int8_t",  "i"}}, tformat("instr_ri(c, 0, i, 1, 1, 0xa8, 0, NO_MODRM)"));
+	form("test", "ax_i16",  {{"int16_t", "i"}}, tformat("instr_ri(c, 0, i, 2, 2, 0xa9, 0, NO_MODRM | OSO)"));
+	form("test", "eax_i32", {{"int32_t", "i"}}, tformat("instr_ri(c, 0, i, 4, 4, 0xa9, 0, NO_MODRM)"));
+	form("test", "rax_i32", {{"int32_t", "i"}}, tformat("instr_ri(c, 0, i, 8, 4, 0xa9, 0, NO_MODRM | REXW)"));
+
+	// Condition may test any of these
+	u16 cond_flags = CF | PF | ZF | SF | OF;
+
+	++group;
+	effects = {.access = "rw", .flags_read = cond_flags};
+	form("setcc", "r8", {{"x64w_Cond", "cc"}, {"x64w_Gpr8", "d"}}, tformat("instr_r(c, d.i, 1, 0x0f90 | cc, 0, 0)"));
+	form("setcc", "m8", {{"x64w_Cond", "cc"}, {"x64w_Mem",  "d"}}, tformat("instr_m(c,   d,    0x0f90 | cc, 0, 0)"));
+
+	++group;
+	effects = {.access = "rxr", .flags_read = cond_flags};
+	form("cmovcc", "rr16", {{"x64w_Cond", "cc"}, {"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, d.i, s.i, 2, 0x0f40 | cc, OSO)"));
+	form("cmovcc", "rr32", {{"x64w_Cond", "cc"}, {"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, 0x0f40 | cc, 0)"));
+	form("cmovcc", "rr64", {{"x64w_Cond", "cc"}, {"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, 0x0f40 | cc, REXW)"));
+	form("cmovcc", "rm16", {{"x64w_Cond", "cc"}, {"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 2, 0x0f40 | cc, OSO)"));
+	form("cmovcc", "rm32", {{"x64w_Cond", "cc"}, {"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, 0x0f40 | cc, 0)"));
+	form("cmovcc", "rm64", {{"x64w_Cond", "cc"}, {"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, 0x0f40 | cc, REXW)"));
+
+	// Displacement is relative to the end of the instruction.
+	++group;
+	effects = {.access = "rr", .flags_read = cond_flags};
+	form("jcc", "i8",  {{"x64w_Cond", "cc"}, {"int8_t",  "i"}}, tformat("instr_i1(c, i, 0x70 | cc)"));
+	form("jcc", "i32", {{"x64w_Cond", "cc"}, {"int32_t", "i"}}, tformat("instr_i4(c, i, 0x0f80 | cc)"));
+
+	++group;
+	effects = {.access = "xr", .flags_written = CF | OF, .flags_undefined = PF | AF | ZF | SF};
+	form("imul", "rr16",    {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, d.i, s.i, 2, 0x0faf, OSO)"));
+	form("imul", "rr32",    {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, 0x0faf, 0)"));
+	form("imul", "rr64",    {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, 0x0faf, REXW)"));
+	form("imul", "rm16",    {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 2, 0x0faf, OSO)"));
+	form("imul", "rm32",    {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, 0x0faf, 0)"));
+	form("imul", "rm64",    {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, 0x0faf, REXW)"));
+	effects = {.access = "wrr", .flags_written = CF | OF, .flags_undefined = PF | AF | ZF | SF};
+	form("imul", "rri16",   {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}, {"int16_t", "i"}}, tformat("instr_rri(c, d.i, s.i, i, 2, 2, 0x69, OSO)"));
+	form("imul", "rri32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"int32_t", "i"}}, tformat("instr_rri(c, d.i, s.i, i, 4, 4, 0x69, 0)"));
+	form("imul", "rr64i32", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"int32_t", "i"}}, tformat("instr_rri(c, d.i, s.i, i, 8, 4, 0x69, REXW)"));
+	form("imul", "rr16i8",  {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}, {"int8_t",  "i"}}, tformat("instr_rri(c, d.i, s.i, i, 2, 1, 0x6b, OSO)"));
+	form("imul", "rr32i8",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"int8_t",  "i"}}, tformat("instr_rri(c, d.i, s.i, i, 4, 1, 0x6b, 0)"));
+	form("imul", "rr64i8",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"int8_t",  "i"}}, tformat("instr_rri(c, d.i, s.i, i, 8, 1, 0x6b, REXW)"));
+	form("imul", "rmi16",   {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}, {"int16_t", "i"}}, tformat("instr_rmi(c, d.i,   s, i, 2, 2, 0x69, OSO)"));
+	form("imul", "rmi32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"int32_t", "i"}}, tformat("instr_rmi(c, d.i,   s, i, 4, 4, 0x69, 0)"));
+	form("imul", "rm64i32", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"int32_t", "i"}}, tformat("instr_rmi(c, d.i,   s, i, 8, 4, 0x69, REXW)"));
+	form("imul", "rm16i8",  {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}, {"int8_t",  "i"}}, tformat("instr_rmi(c, d.i,   s, i, 2, 1, 0x6b, OSO)"));
+	form("imul", "rm32i8",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"int8_t",  "i"}}, tformat("instr_rmi(c, d.i,   s, i, 4, 1, 0x6b, 0)"));
+	form("imul", "rm64i8",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"int8_t",  "i"}}, tformat("instr_rmi(c, d.i,   s, i, 8, 1, 0x6b, REXW)"));
+
+	// r, r/m of smaller size
+	auto I5 = [&](char const *mnem, u8 op) {
+		++group;
+		effects = {.access = "wr"};
+		form(mnem, "r16r8",  {{"x64w_Gpr16", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr8(c, d.i, s.i,    {},     OSO)", hex(0x0f00 | op)));
+		form(mnem, "r32r8",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr8(c, d.i, s.i,    {},       0)", hex(0x0f00 | op)));
+		form(mnem, "r64r8",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr8(c, d.i, s.i,    {},    REXW)", hex(0x0f00 | op)));
+		form(mnem, "r32r16", {{"x64w_Gpr32", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr (c, d.i, s.i, 4, {},       0)", hex(0x0f00 | op | 1)));
+		form(mnem, "r64r16", {{"x64w_Gpr64", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr (c, d.i, s.i, 8, {},    REXW)", hex(0x0f00 | op | 1)));
+		form(mnem, "r16m8",  {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 2, {},     OSO)", hex(0x0f00 | op)));
+		form(mnem, "r32m8",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 4, {},       0)", hex(0x0f00 | op)));
+		form(mnem, "r64m8",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 8, {},    REXW)", hex(0x0f00 | op)));
+		form(mnem, "r32m16", {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 4, {},       0)", hex(0x0f00 | op | 1)));
+		form(mnem, "r64m16", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 8, {},    REXW)", hex(0x0f00 | op | 1)));
+	};
+
+	I5("movzx", 0xb6);
+	I5("movsx", 0xbe);
+
+	++group;
+	effects = {.access = "wr"};
+	form("movsxd", "r64r32", {{"x64w_Gpr64", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, 0x63, REXW)"));
+	form("movsxd", "r64m32", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, 0x63, REXW)"));
+
+	// Sign extension of the accumulator
+	++group;
+	effects = {.access = "", .implicit_read = RAX, .implicit_write = RAX};
+	form("cbw",  "", {}, tformat("instr(c, 0x98, OSO)"));
+	form("cwde", "", {}, tformat("instr(c, 0x98, 0)"));
+	form("cdqe", "", {}, tformat("instr(c, 0x98, REXW)"));
+	effects = {.access = "", .implicit_read = RAX, .implicit_write = RDX};
+	form("cwd",  "", {}, tformat("instr(c, 0x99, OSO)"));
+	form("cdq",  "", {}, tformat("instr(c, 0x99, 0)"));
+	form("cqo",  "", {}, tformat("instr(c, 0x99, REXW)"));
+
+	// String instructions: elements of size b/w/d/q at [rsi] and [rdi], both advanced past the element,
+	// backwards if DF is set. Prefixed forms repeat rcx times, repe/repne also stop on the comparison result.
+	struct E7 {
+		char const *mnem[4];
+		u8 op;
+	};
+	auto S1 = [&](E7 e, char const *prefix, Effects eff) {
+		auto flags = [&](char const *size_flag) -> Span<char> {
+			if (!*prefix) return tformat("{}", size_flag);
+			if (size_flag[0] == '0') return tformat("{}", prefix);
+			return tformat("{} | {}", prefix, size_flag);
+		};
+		if (*prefix) {
+			eff.implicit_read  |= RCX;
+			eff.implicit_write |= RCX;
+		}
+		++group;
+		effects = eff;
+		form(e.mnem[0], "", {}, tformat("instr(c, {}, {})", hex(e.op),             flags("0")));
+		form(e.mnem[1], "", {}, tformat("instr(c, {}, {})", hex((u8)(e.op + 1)), flags("OSO")));
+		form(e.mnem[2], "", {}, tformat("instr(c, {}, {})", hex((u8)(e.op + 1)), flags("0")));
+		form(e.mnem[3], "", {}, tformat("instr(c, {}, {})", hex((u8)(e.op + 1)), flags("REXW")));
+	};
+
+	Effects movs = {.access = "", .implicit_read = RSI | RDI, .implicit_write = RSI | RDI, .flags_read = DF};
+	Effects stos = {.access = "", .implicit_read = RAX | RDI, .implicit_write = RDI,       .flags_read = DF};
+	Effects lods = {.access = "", .implicit_read = RSI,       .implicit_write = RAX | RSI, .flags_read = DF};
+	Effects scas = {.access = "", .implicit_read = RAX | RDI, .implicit_write = RDI,       .flags_read = DF, .flags_written = STATUS};
+	Effects cmps = {.access = "", .implicit_read = RSI | RDI, .implicit_write = RSI | RDI, .flags_read = DF, .flags_written = STATUS};
+
+	S1({{"movsb",       "movsw",       "movsd",       "movsq"},       0xa4}, "",      movs);
+	S1({{"rep_movsb",   "rep_movsw",   "rep_movsd",   "rep_movsq"},   0xa4}, "REP",   movs);
+	S1({{"stosb",       "stosw",       "stosd",       "stosq"},       0xaa}, "",      stos);
+	S1({{"rep_stosb",   "rep_stosw",   "rep_stosd",   "rep_stosq"},   0xaa}, "REP",   stos);
+	S1({{"lodsb",       "lodsw",       "lodsd",       "lodsq"},       0xac}, "",      lods);
+	S1({{"scasb",       "scasw",       "scasd",       "scasq"},       0xae}, "",      scas);
+	S1({{"repe_scasb",  "repe_scasw",  "repe_scasd",  "repe_scasq"},  0xae}, "REP",   scas);
+	S1({{"repne_scasb", "repne_scasw", "repne_scasd", "repne_scasq"}, 0xae}, "REPNE", scas);
+	S1({{"cmpsb",       "cmpsw",       "cmpsd",       "cmpsq"},       0xa6}, "",      cmps);
+	S1({{"repe_cmpsb",  "repe_cmpsw",  "repe_cmpsd",  "repe_cmpsq"},  0xa6}, "REP",   cmps);
+	S1({{"repne_cmpsb", "repne_cmpsw", "repne_cmpsd", "repne_cmpsq"}, 0xa6}, "REPNE", cmps);
+
+	// r16/32/64, r/m16/32/64
+	auto I6 = [&](char const *mnem, u16 op, char const *prefix, Effects e) {
+		auto flags = [&](char const *size_flag) -> Span<char> {
+			if (!*prefix) return tformat("{}", size_flag);
+			if (size_flag[0] == '0') return tformat("{}", prefix);
+			return tformat("{} | {}", prefix, size_flag);
+		};
+		++group;
+		effects = e;
+		form(mnem, "rr16", {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, d.i, s.i, 2, {}, {})", hex(op), flags("OSO")));
+		form(mnem, "rr32", {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, {}, {})", hex(op), flags("0")));
+		form(mnem, "rr64", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, {}, {})", hex(op), flags("REXW")));
+		form(mnem, "rm16", {{"x64w_Gpr16", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 2, {}, {})", hex(op), flags("OSO")));
+		form(mnem, "rm32", {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, {}, {})", hex(op), flags("0")));
+		form(mnem, "rm64", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, {}, {})", hex(op), flags("REXW")));
+	};
+
+	// Destination is left unchanged if the source is zero, so it is read too.
+	I6("bsf",    0x0fbc, "", {.access = "xr", .flags_written = ZF, .flags_undefined = CF | PF | AF | SF | OF});
+	I6("bsr",    0x0fbd, "", {.access = "xr", .flags_written = ZF, .flags_undefined = CF | PF | AF | SF | OF});
+	I6("popcnt", 0x0fb8, "REP", {.access = "wr", .flags_written = STATUS});
+
+	Effects arith = {.access = "xr", .flags_written = STATUS};
+	Effects logic = {.access = "xr", .flags_written = STATUS & ~AF, .flags_undefined = AF};
+
+	I1("adc", {.op = {0x80, 0x81, 0x83, 0x10, 0x11, 0x12, 0x13}, .mod = 2,}, {.access = "xr", .flags_read = CF, .flags_written = STATUS}, "lock_adc");
+	I1("add", {.op = {0x80, 0x81, 0x83, 0x00, 0x01, 0x02, 0x03}, .mod = 0,}, arith, "lock_add");
+	I1("xor", {.op = {0x80, 0x81, 0x83, 0x30, 0x31, 0x32, 0x33}, .mod = 6,}, logic, "lock_xor");
+	I1("and", {.op = {0x80, 0x81, 0x83, 0x20, 0x21, 0x22, 0x23}, .mod = 4,}, logic, "lock_and");
+	I1("or",  {.op = {0x80, 0x81, 0x83, 0x08, 0x09, 0x0a, 0x0b}, .mod = 1,}, logic, "lock_or");
+	I1("sub", {.op = {0x80, 0x81, 0x83, 0x28, 0x29, 0x2a, 0x2b}, .mod = 5,}, arith, "lock_sub");
+	I1("cmp", {.op = {0x80, 0x81, 0x83, 0x38, 0x39, 0x3a, 0x3b}, .mod = 7,}, {.access = "rr", .flags_written = STATUS});
+	I2("inc",  {.op = {0xfe, 0xff}, .mod = 0}, {.access = "x", .flags_written = STATUS & ~CF}, "lock_inc");
+	I2("dec",  {.op = {0xfe, 0xff}, .mod = 1}, {.access = "x", .flags_written = STATUS & ~CF}, "lock_dec");
+	I2("not",  {.op = {0xf6, 0xf7}, .mod = 2}, {.access = "x"}, "lock_not");
+	I2("neg",  {.op = {0xf6, 0xf7}, .mod = 3}, {.access = "x", .flags_written = STATUS}, "lock_neg");
+	I2("mul",  {.op = {0xf6, 0xf7}, .mod = 4}, {.access = "r", .implicit_read = RAX, .implicit_write = RAX | RDX, .flags_written = CF | OF, .flags_undefined = PF | AF | ZF | SF});
+	I2("imul", {.op = {0xf6, 0xf7}, .mod = 5}, {.access = "r", .implicit_read = RAX, .implicit_write = RAX | RDX, .flags_written = CF | OF, .flags_undefined = PF | AF | ZF | SF});
+	I2("div",  {.op = {0xf6, 0xf7}, .mod = 6}, {.access = "r", .implicit_read = RAX | RDX, .implicit_write = RAX | RDX, .flags_undefined = STATUS});
+	I2("idiv", {.op = {0xf6, 0xf7}, .mod = 7}, {.access = "r", .implicit_read = RAX | RDX, .implicit_write = RAX | RDX, .flags_undefined = STATUS});
+	I3("shl", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 4}, logic);
+	I3("shr", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 5}, logic);
+	I3("sal", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 4}, logic);
+	I3("sar", {.op = {0xd0, 0xd1, 0xd2, 0xd3, 0xc0, 0xc1}, .mod = 7}, logic);
+	I4("lea", {.op = 0x8d}, {.access = "wn"});
+
+	// Non-temporal store, goes around the caches
+	++group;
+	effects = {.access = "wr"};
+	form("movnti", "mr32", {{"x64w_Mem", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i, d, 4, 0x0fc3, 0)"));
+	form("movnti", "mr64", {{"x64w_Mem", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i, d, 8, 0x0fc3, REXW)"));
+
+	// Prefetches are hints that never fault, only the address is used.
+	++group;
+	effects = {.access = "n"};
+	form("prefetcht0",  "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0f18, 1, 0)"));
+	form("prefetcht1",  "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0f18, 2, 0)"));
+	form("prefetcht2",  "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0f18, 3, 0)"));
+	form("prefetchnta", "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0f18, 0, 0)"));
+	form("prefetchw",   "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0f0d, 1, 0)"));
+
+	// Write back the cache line, clwb may keep it cached. Ordered after older stores to the same line.
+	++group;
+	effects = {.access = "r"};
+	form("clflushopt", "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0fae, 7, OSO)"));
+	form("clwb",       "m8", {{"x64w_Mem", "m"}}, tformat("instr_m(c, m, 0x0fae, 6, OSO)"));
+
+	// Stores before it become visible before stores after it, non-temporal included.
+	++group;
+	effects = {.access = ""};
+	form("sfence", "", {}, tformat("instr(c, 0x0faef8, 0)"));
+	// Loads before it complete before anything after it starts
+	form("lfence", "", {}, tformat("instr(c, 0x0faee8, 0)"));
+	// Loads and stores before it become visible before loads and stores after it
+	form("mfence", "", {}, tformat("instr(c, 0x0faef0, 0)"));
+	// Spin-wait loop hint
+	form("pause",  "", {}, tformat("instr(c, 0x90, REP)"));
+
+	// Time stamp counter goes to edx:eax. rdtsc doesn't wait for preceding instructions,
+	// put lfence or cpuid before it for that. rdtscp does wait and also returns IA32_TSC_AUX in ecx.
+	++group;
+	effects = {.access = "", .implicit_write = RAX | RDX};
+	form("rdtsc",  "", {}, tformat("instr(c, 0x0f31, 0)"));
+	effects = {.access = "", .implicit_write = RAX | RCX | RDX};
+	form("rdtscp", "", {}, tformat("instr(c, 0x0f01f9, 0)"));
+	// Performance counter selected by ecx
+	effects = {.access = "", .implicit_read = RCX, .implicit_write = RAX | RDX};
+	form("rdpmc",  "", {}, tformat("instr(c, 0x0f33, 0)"));
+	// Leaf in eax, subleaf in ecx. Serializes execution.
+	effects = {.access = "", .implicit_read = RAX | RCX, .implicit_write = RAX | RBX | RCX | RDX};
+	form("cpuid",  "", {}, tformat("instr(c, 0x0fa2, 0)"));
+
+	// Exchange with memory is atomic even without lock prefix.
+	++group;
+	effects = {.access = "xx"};
+	form("xchg", "rr8",  {{"x64w_Gpr8",  "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr(c, s.i, d.i, 1, 0x86, 0)"));
+	form("xchg", "rr16", {{"x64w_Gpr16", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr(c, s.i, d.i, 2, 0x87, OSO)"));
+	form("xchg", "rr32", {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, s.i, d.i, 4, 0x87, 0)"));
+	form("xchg", "rr64", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, s.i, d.i, 8, 0x87, REXW)"));
+	form("xchg", "mr8",  {{"x64w_Mem",   "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i,   d, 1, 0x86, 0)"));
+	form("xchg", "mr16", {{"x64w_Mem",   "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i,   d, 2, 0x87, OSO)"));
+	form("xchg", "mr32", {{"x64w_Mem",   "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i,   d, 4, 0x87, 0)"));
+	form("xchg", "mr64", {{"x64w_Mem",   "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i,   d, 8, 0x87, REXW)"));
+
+	// Compares rax with d, if equal stores s to d, otherwise loads d to rax.
+	// Destination is written back even if comparison fails.
+	++group;
+	effects = {.access = "xr", .implicit_read = RAX, .implicit_write = RAX, .flags_written = STATUS};
+	form("cmpxchg",      "mr8",  {{"x64w_Mem", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i, d, 1, 0x0fb0, 0)"));
+	form("cmpxchg",      "mr16", {{"x64w_Mem", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i, d, 2, 0x0fb1, OSO)"));
+	form("cmpxchg",      "mr32", {{"x64w_Mem", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i, d, 4, 0x0fb1, 0)"));
+	form("cmpxchg",      "mr64", {{"x64w_Mem", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i, d, 8, 0x0fb1, REXW)"));
+	form("lock_cmpxchg", "mr8",  {{"x64w_Mem", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i, d, 1, 0x0fb0, LOCK)"));
+	form("lock_cmpxchg", "mr16", {{"x64w_Mem", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i, d, 2, 0x0fb1, LOCK | OSO)"));
+	form("lock_cmpxchg", "mr32", {{"x64w_Mem", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i, d, 4, 0x0fb1, LOCK)"));
+	form("lock_cmpxchg", "mr64", {{"x64w_Mem", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i, d, 8, 0x0fb1, LOCK | REXW)"));
+
+	// Same with rdx:rax and rcx:rbx, cmpxchg16b requires 16-byte aligned memory.
+	++group;
+	effects = {.access = "x", .implicit_read = RAX | RCX | RDX | RBX, .implicit_write = RAX | RDX, .flags_written = ZF};
+	form("cmpxchg8b",       "m64",  {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, 0x0fc7, 1, 0)"));
+	form("cmpxchg16b",      "m128", {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, 0x0fc7, 1, REXW)"));
+	form("lock_cmpxchg8b",  "m64",  {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, 0x0fc7, 1, LOCK)"));
+	form("lock_cmpxchg16b", "m128", {{"x64w_Mem", "d"}}, tformat("instr_m(c, d, 0x0fc7, 1, LOCK | REXW)"));
+
+	// Stores d + s to d, previous value of d goes to s.
+	++group;
+	effects = {.access = "xx", .flags_written = STATUS};
+	form("xadd",      "mr8",  {{"x64w_Mem", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i, d, 1, 0x0fc0, 0)"));
+	form("xadd",      "mr16", {{"x64w_Mem", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i, d, 2, 0x0fc1, OSO)"));
+	form("xadd",      "mr32", {{"x64w_Mem", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i, d, 4, 0x0fc1, 0)"));
+	form("xadd",      "mr64", {{"x64w_Mem", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i, d, 8, 0x0fc1, REXW)"));
+	form("lock_xadd", "mr8",  {{"x64w_Mem", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rm(c, s.i, d, 1, 0x0fc0, LOCK)"));
+	form("lock_xadd", "mr16", {{"x64w_Mem", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rm(c, s.i, d, 2, 0x0fc1, LOCK | OSO)"));
+	form("lock_xadd", "mr32", {{"x64w_Mem", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rm(c, s.i, d, 4, 0x0fc1, LOCK)"));
+	form("lock_xadd", "mr64", {{"x64w_Mem", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rm(c, s.i, d, 8, 0x0fc1, LOCK | REXW)"));
+
+	extension = ext_apx;
+	I1_ndd("adc", {.op = {0x80, 0x81, 0x83, 0x10, 0x11, 0x12, 0x13}, .mod = 2,}, {.access = "xr", .flags_read = CF, .flags_written = STATUS});
+	I1_ndd("add", {.op = {0x80, 0x81, 0x83, 0x00, 0x01, 0x02, 0x03}, .mod = 0,}, arith);
+	I1_ndd("xor", {.op = {0x80, 0x81, 0x83, 0x30, 0x31, 0x32, 0x33}, .mod = 6,}, logic);
+	I1_ndd("and", {.op = {0x80, 0x81, 0x83, 0x20, 0x21, 0x22, 0x23}, .mod = 4,}, logic);
+	I1_ndd("or",  {.op = {0x80, 0x81, 0x83, 0x08, 0x09, 0x0a, 0x0b}, .mod = 1,}, logic);
+	I1_ndd("sub", {.op = {0x80, 0x81, 0x83, 0x28, 0x29, 0x2a, 0x2b}, .mod = 5,}, arith);
+
+	extension = ext_adx;
+	++group;
+	effects = {.access = "xr", .flags_read = CF, .flags_written = CF};
+	form("adcx", "rr32", {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, 0x0f38f6, OSO)"));
+	form("adcx", "rr64", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, 0x0f38f6, OSO | REXW)"));
+	form("adcx", "rm32", {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, 0x0f38f6, OSO)"));
+	form("adcx", "rm64", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, 0x0f38f6, OSO | REXW)"));
+	// Carries through OF, leaving CF to an interleaved adcx chain
+	effects = {.access = "xr", .flags_read = OF, .flags_written = OF};
+	form("adox", "rr32", {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, 0x0f38f6, REP)"));
+	form("adox", "rr64", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, 0x0f38f6, REP | REXW)"));
+	form("adox", "rm32", {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, 0x0f38f6, REP)"));
+	form("adox", "rm64", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, 0x0f38f6, REP | REXW)"));
+
+	extension = ext_bmi;
+	++group;
+	effects = {.access = "wrr", .flags_written = CF | ZF | SF | OF, .flags_undefined = AF | PF};
+	form("andn",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Gpr32", "b"}}, tformat("instr_vrr(c, d.i, a.i, b.i, 4, 0x0f38f2, 0)"));
+	form("andn",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Gpr64", "b"}}, tformat("instr_vrr(c, d.i, a.i, b.i, 8, 0x0f38f2, REXW)"));
+	form("andn",   "rrm32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_vrm(c, d.i, a.i,   b, 4, 0x0f38f2, 0)"));
+	form("andn",   "rrm64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_vrm(c, d.i, a.i,   b, 8, 0x0f38f2, REXW)"));
+
+	++group;
+	effects = {.access = "wrr", .flags_written = CF | ZF | OF, .flags_undefined = AF | SF | PF};
+	form("bextr",  "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"x64w_Gpr32", "i"}}, tformat("instr_vrr(c, d.i, i.i, s.i, 4, 0x0f38f7, 0)"));
+	form("bextr",  "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"x64w_Gpr64", "i"}}, tformat("instr_vrr(c, d.i, i.i, s.i, 8, 0x0f38f7, REXW)"));
+	form("bextr",  "rmr32",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr32", "i"}}, tformat("instr_vrm(c, d.i, i.i,   s, 4, 0x0f38f7, 0)"));
+	form("bextr",  "rmr64",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr64", "i"}}, tformat("instr_vrm(c, d.i, i.i,   s, 8, 0x0f38f7, REXW)"));
+
+	++group;
+	effects = {.access = "wr", .flags_written = CF | ZF | SF | OF, .flags_undefined = AF | PF};
+	form("blsr",   "rr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_vrr(c, 1, d.i, s.i, 4, 0x0f38f3, 0)"));
+	form("blsr",   "rr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_vrr(c, 1, d.i, s.i, 8, 0x0f38f3, REXW)"));
+	form("blsr",   "rm32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, 1, d.i,   s, 4, 0x0f38f3, 0)"));
+	form("blsr",   "rm64",   {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, 1, d.i,   s, 8, 0x0f38f3, REXW)"));
+	form("blsmsk", "rr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_vrr(c, 2, d.i, s.i, 4, 0x0f38f3, 0)"));
+	form("blsmsk", "rr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_vrr(c, 2, d.i, s.i, 8, 0x0f38f3, REXW)"));
+	form("blsmsk", "rm32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, 2, d.i,   s, 4, 0x0f38f3, 0)"));
+	form("blsmsk", "rm64",   {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, 2, d.i,   s, 8, 0x0f38f3, REXW)"));
+	form("blsi",   "rr32",   {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_vrr(c, 3, d.i, s.i, 4, 0x0f38f3, 0)"));
+	form("blsi",   "rr64",   {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_vrr(c, 3, d.i, s.i, 8, 0x0f38f3, REXW)"));
+	form("blsi",   "rm32",   {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, 3, d.i,   s, 4, 0x0f38f3, 0)"));
+	form("blsi",   "rm64",   {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, 3, d.i,   s, 8, 0x0f38f3, REXW)"));
+
+	++group;
+	effects = {.access = "wrr", .flags_written = CF | ZF | SF | OF, .flags_undefined = AF | PF};
+	form("bzhi",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"x64w_Gpr32", "i"}}, tformat("instr_vrr(c, d.i, i.i, s.i, 4, 0x0f38f5, 0)"));
+	form("bzhi",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"x64w_Gpr64", "i"}}, tformat("instr_vrr(c, d.i, i.i, s.i, 8, 0x0f38f5, REXW)"));
+	form("bzhi",   "rmr32",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr32", "i"}}, tformat("instr_vrm(c, d.i, i.i,   s, 4, 0x0f38f5, 0)"));
+	form("bzhi",   "rmr64",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr64", "i"}}, tformat("instr_vrm(c, d.i, i.i,   s, 8, 0x0f38f5, REXW)"));
+
+	++group;
+	effects = {.access = "wrr"};
+	form("shlx",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"x64w_Gpr32", "n"}}, tformat("instr_vrr(c, d.i, n.i, s.i, 4, 0x0f38f7, OSO)"));
+	form("shlx",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"x64w_Gpr64", "n"}}, tformat("instr_vrr(c, d.i, n.i, s.i, 8, 0x0f38f7, OSO | REXW)"));
+	form("shlx",   "rmr32",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr32", "n"}}, tformat("instr_vrm(c, d.i, n.i,   s, 4, 0x0f38f7, OSO)"));
+	form("shlx",   "rmr64",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr64", "n"}}, tformat("instr_vrm(c, d.i, n.i,   s, 8, 0x0f38f7, OSO | REXW)"));
+	form("sarx",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"x64w_Gpr32", "n"}}, tformat("instr_vrr(c, d.i, n.i, s.i, 4, 0x0f38f7, REP)"));
+	form("sarx",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"x64w_Gpr64", "n"}}, tformat("instr_vrr(c, d.i, n.i, s.i, 8, 0x0f38f7, REP | REXW)"));
+	form("sarx",   "rmr32",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr32", "n"}}, tformat("instr_vrm(c, d.i, n.i,   s, 4, 0x0f38f7, REP)"));
+	form("sarx",   "rmr64",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr64", "n"}}, tformat("instr_vrm(c, d.i, n.i,   s, 8, 0x0f38f7, REP | REXW)"));
+	form("shrx",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"x64w_Gpr32", "n"}}, tformat("instr_vrr(c, d.i, n.i, s.i, 4, 0x0f38f7, REPNE)"));
+	form("shrx",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"x64w_Gpr64", "n"}}, tformat("instr_vrr(c, d.i, n.i, s.i, 8, 0x0f38f7, REPNE | REXW)"));
+	form("shrx",   "rmr32",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr32", "n"}}, tformat("instr_vrm(c, d.i, n.i,   s, 4, 0x0f38f7, REPNE)"));
+	form("shrx",   "rmr64",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"x64w_Gpr64", "n"}}, tformat("instr_vrm(c, d.i, n.i,   s, 8, 0x0f38f7, REPNE | REXW)"));
+
+	++group;
+	effects = {.access = "wrr"};
+	form("rorx",   "rri32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}, {"uint8_t",    "i"}}, tformat("instr_vrri(c, d.i, s.i, i, 4, 0x0f3af0, REPNE)"));
+	form("rorx",   "rri64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}, {"uint8_t",    "i"}}, tformat("instr_vrri(c, d.i, s.i, i, 8, 0x0f3af0, REPNE | REXW)"));
+	form("rorx",   "rmi32",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}, {"uint8_t",    "i"}}, tformat("instr_vrmi(c, d.i,   s, i, 4, 0x0f3af0, REPNE)"));
+	form("rorx",   "rmi64",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}, {"uint8_t",    "i"}}, tformat("instr_vrmi(c, d.i,   s, i, 8, 0x0f3af0, REPNE | REXW)"));
+
+	++group;
+	effects = {.access = "wrr"};
+	form("pdep",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Gpr32", "b"}}, tformat("instr_vrr(c, d.i, a.i, b.i, 4, 0x0f38f5, REPNE)"));
+	form("pdep",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Gpr64", "b"}}, tformat("instr_vrr(c, d.i, a.i, b.i, 8, 0x0f38f5, REPNE | REXW)"));
+	form("pdep",   "rrm32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_vrm(c, d.i, a.i,   b, 4, 0x0f38f5, REPNE)"));
+	form("pdep",   "rrm64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_vrm(c, d.i, a.i,   b, 8, 0x0f38f5, REPNE | REXW)"));
+	form("pext",   "rrr32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Gpr32", "b"}}, tformat("instr_vrr(c, d.i, a.i, b.i, 4, 0x0f38f5, REP)"));
+	form("pext",   "rrr64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Gpr64", "b"}}, tformat("instr_vrr(c, d.i, a.i, b.i, 8, 0x0f38f5, REP | REXW)"));
+	form("pext",   "rrm32",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_vrm(c, d.i, a.i,   b, 4, 0x0f38f5, REP)"));
+	form("pext",   "rrm64",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "a"}, {"x64w_Mem",   "b"}}, tformat("instr_vrm(c, d.i, a.i,   b, 8, 0x0f38f5, REP | REXW)"));
+
+	++group;
+	// High half of rdx * s goes to h, low half - to l
+	effects = {.access = "wwr", .implicit_read = RDX};
+	form("mulx",   "rrr32",  {{"x64w_Gpr32", "h"}, {"x64w_Gpr32", "l"}, {"x64w_Gpr32", "s"}}, tformat("instr_vrr(c, h.i, l.i, s.i, 4, 0x0f38f6, REPNE)"));
+	form("mulx",   "rrr64",  {{"x64w_Gpr64", "h"}, {"x64w_Gpr64", "l"}, {"x64w_Gpr64", "s"}}, tformat("instr_vrr(c, h.i, l.i, s.i, 8, 0x0f38f6, REPNE | REXW)"));
+	form("mulx",   "rrm32",  {{"x64w_Gpr32", "h"}, {"x64w_Gpr32", "l"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, h.i, l.i,   s, 4, 0x0f38f6, REPNE)"));
+	form("mulx",   "rrm64",  {{"x64w_Gpr64", "h"}, {"x64w_Gpr64", "l"}, {"x64w_Mem",   "s"}}, tformat("instr_vrm(c, h.i, l.i,   s, 8, 0x0f38f6, REPNE | REXW)"));
+
+	I6("lzcnt", 0x0fbd, "REP", {.access = "wr", .flags_written = CF | ZF, .flags_undefined = PF | AF | SF | OF});
+	I6("tzcnt", 0x0fbc, "REP", {.access = "wr", .flags_written = CF | ZF, .flags_undefined = PF | AF | SF | OF});
+
+	extension = ext_sse;
+	++group;
+	effects = {.access = "xr"};
+	form("addpd", "xx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rr(c, d.i, s.i, 16, 0x0f58, OSO)"));
+	form("addpd", "xm", {{"x64w_Xmm", "d"}, {"x64w_Mem", "s"}}, tformat("instr_rm(c, d.i, s,   16, 0x0f58, OSO)"));
+
+	// Opcode with as many bytes as it has: 0x58, 0x0f58 or 0x0f3858
+	auto opcode_hex = [&](u32 op) -> Span<char> {
+		if (op <= 0xff)   return hex((u8)op);
+		if (op <= 0xffff) return hex((u16)op);
+		return tformat("0x{}{}", format_hex((u8)(op >> 16)), format_hex((u16)op));
+	};
+
+	// xmm, xmm/m
+	auto I7 = [&](char const *mnem, u32 op, char const *flags, Effects e) {
+		++group;
+		effects = e;
+		form(mnem, "xx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rr(c, d.i, s.i, 16, {}, {})", opcode_hex(op), flags));
+		form(mnem, "xm", {{"x64w_Xmm", "d"}, {"x64w_Mem", "s"}}, tformat("instr_rm(c, d.i, s,   16, {}, {})", opcode_hex(op), flags));
+	};
+
+	// Scalar operations only replace the low element of the destination.
+	Effects scalar = {.access = "xr"};
+
+	I7("addss",    0x0f58, "REP",   scalar);
+	I7("addsd",    0x0f58, "REPNE", scalar);
+	I7("subss",    0x0f5c, "REP",   scalar);
+	I7("subsd",    0x0f5c, "REPNE", scalar);
+	I7("mulss",    0x0f59, "REP",   scalar);
+	I7("mulsd",    0x0f59, "REPNE", scalar);
+	I7("divss",    0x0f5e, "REP",   scalar);
+	I7("divsd",    0x0f5e, "REPNE", scalar);
+	I7("sqrtss",   0x0f51, "REP",   scalar);
+	I7("sqrtsd",   0x0f51, "REPNE", scalar);
+	I7("cvtss2sd", 0x0f5a, "REP",   scalar);
+	I7("cvtsd2ss", 0x0f5a, "REPNE", scalar);
+	I7("ucomiss",  0x0f2e, "0",     {.access = "rr", .flags_written = STATUS});
+	I7("ucomisd",  0x0f2e, "OSO",   {.access = "rr", .flags_written = STATUS});
+	I7("comiss",   0x0f2f, "0",     {.access = "rr", .flags_written = STATUS});
+	I7("comisd",   0x0f2f, "OSO",   {.access = "rr", .flags_written = STATUS});
+
+	// Register to register move merges, load from memory zeroes the upper elements.
+	auto I8 = [&](char const *mnem, char const *flags) {
+		++group;
+		effects = {.access = "xr"};
+		form(mnem, "xx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rr(c, d.i, s.i, 16, 0x0f10, {})", flags));
+		effects = {.access = "wr"};
+		form(mnem, "xm", {{"x64w_Xmm", "d"}, {"x64w_Mem", "s"}}, tformat("instr_rm(c, d.i, s,   16, 0x0f10, {})", flags));
+		form(mnem, "mx", {{"x64w_Mem", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rm(c, s.i, d,   16, 0x0f11, {})", flags));
+	};
+
+	I8("movss", "REP");
+	I8("movsd", "REPNE");
+
+	// xmm, r/m32/64
+	auto I9 = [&](char const *mnem, u16 op, char const *flags32, char const *flags64) {
+		++group;
+		effects = scalar;
+		form(mnem, "xr32", {{"x64w_Xmm", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, {}, {})", hex(op), flags32));
+		form(mnem, "xr64", {{"x64w_Xmm", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, {}, {})", hex(op), flags64));
+		form(mnem, "xm32", {{"x64w_Xmm", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 4, {}, {})", hex(op), flags32));
+		form(mnem, "xm64", {{"x64w_Xmm", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 8, {}, {})", hex(op), flags64));
+	};
+
+	I9("cvtsi2ss", 0x0f2a, "REP",   "REP | REXW");
+	I9("cvtsi2sd", 0x0f2a, "REPNE", "REPNE | REXW");
+
+	// r32/64, xmm/m
+	auto I10 = [&](char const *mnem, u16 op, char const *flags32, char const *flags64) {
+		++group;
+		effects = {.access = "wr"};
+		form(mnem, "r32x", {{"x64w_Gpr32", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rr(c, d.i, s.i, 4, {}, {})", hex(op), flags32));
+		form(mnem, "r64x", {{"x64w_Gpr64", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rr(c, d.i, s.i, 8, {}, {})", hex(op), flags64));
+		form(mnem, "r32m", {{"x64w_Gpr32", "d"}, {"x64w_Mem", "s"}}, tformat("instr_rm(c, d.i,   s, 4, {}, {})", hex(op), flags32));
+		form(mnem, "r64m", {{"x64w_Gpr64", "d"}, {"x64w_Mem", "s"}}, tformat("instr_rm(c, d.i,   s, 8, {}, {})", hex(op), flags64));
+	};
+
+	I10("cvtss2si",  0x0f2d, "REP",   "REP | REXW");
+	I10("cvtsd2si",  0x0f2d, "REPNE", "REPNE | REXW");
+	I10("cvttss2si", 0x0f2c, "REP",   "REP | REXW");
+	I10("cvttsd2si", 0x0f2c, "REPNE", "REPNE | REXW");
+
+	// Moves between general purpose and xmm registers zero the upper elements.
+	++group;
+	effects = {.access = "wr"};
+	form("movd", "xr32", {{"x64w_Xmm",   "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr(c, d.i, s.i,  4, 0x0f6e, OSO)"));
+	form("movd", "r32x", {{"x64w_Gpr32", "d"}, {"x64w_Xmm",   "s"}}, tformat("instr_rr(c, s.i, d.i,  4, 0x0f7e, OSO)"));
+	form("movd", "xm",   {{"x64w_Xmm",   "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s,  4, 0x0f6e, OSO)"));
+	form("movd", "mx",   {{"x64w_Mem",   "d"}, {"x64w_Xmm",   "s"}}, tformat("instr_rm(c, s.i,   d,  4, 0x0f7e, OSO)"));
+	form("movq", "xr64", {{"x64w_Xmm",   "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr(c, d.i, s.i,  8, 0x0f6e, OSO | REXW)"));
+	form("movq", "r64x", {{"x64w_Gpr64", "d"}, {"x64w_Xmm",   "s"}}, tformat("instr_rr(c, s.i, d.i,  8, 0x0f7e, OSO | REXW)"));
+	form("movq", "xx",   {{"x64w_Xmm",   "d"}, {"x64w_Xmm",   "s"}}, tformat("instr_rr(c, d.i, s.i, 16, 0x0f7e, REP)"));
+	form("movq", "xm",   {{"x64w_Xmm",   "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm(c, d.i,   s, 16, 0x0f7e, REP)"));
+	form("movq", "mx",   {{"x64w_Mem",   "d"}, {"x64w_Xmm",   "s"}}, tformat("instr_rm(c, s.i,   d, 16, 0x0fd6, OSO)"));
+
+	// Non-temporal store, memory must be aligned to the vector size.
+	++group;
+	effects = {.access = "wr"};
+	form("movntdq", "mx", {{"x64w_Mem", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_rm(c, s.i, d, 16, 0x0fe7, OSO)"));
+
+	// xmm, xmm/m, imm8
+	auto I11 = [&](char const *mnem, u32 op, char const *flags, Effects e) {
+		++group;
+		effects = e;
+		form(mnem, "xxi", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "s"}, {"uint8_t", "i"}}, tformat("instr_rri(c, d.i, s.i, i, 16, 1, {}, {})", opcode_hex(op), flags));
+		form(mnem, "xmi", {{"x64w_Xmm", "d"}, {"x64w_Mem", "s"}, {"uint8_t", "i"}}, tformat("instr_rmi(c, d.i, s,   i, 16, 1, {}, {})", opcode_hex(op), flags));
+	};
+
+	// SSE4.2 string comparison, imm8 selects element format, aggregation and polarity.
+	// Explicit length forms take lengths of the operands in eax and edx.
+	// Index forms return the index in ecx, mask forms return the mask in xmm0.
+	I11("pcmpestri", 0x0f3a61, "OSO", {.access = "rrr", .implicit_read = RAX | RDX, .implicit_write = RCX,                                .flags_written = STATUS});
+	I11("pcmpestrm", 0x0f3a60, "OSO", {.access = "rrr", .implicit_read = RAX | RDX,                        .implicit_vector_write = XMM0, .flags_written = STATUS});
+	I11("pcmpistri", 0x0f3a63, "OSO", {.access = "rrr",                             .implicit_write = RCX,                                .flags_written = STATUS});
+	I11("pcmpistrm", 0x0f3a62, "OSO", {.access = "rrr",                                                    .implicit_vector_write = XMM0, .flags_written = STATUS});
+
+	// SSE4.2 crc32 accumulates the CRC-32C (Castagnoli) of the source into the destination.
+	// Mandatory f2 goes after 66 and before REX.
+	++group;
+	effects = {.access = "xr"};
+	form("crc32", "r32r8",  {{"x64w_Gpr32", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr8(c, d.i, s.i,    0x0f38f0, REPNE)"));
+	form("crc32", "r32r16", {{"x64w_Gpr32", "d"}, {"x64w_Gpr16", "s"}}, tformat("instr_rr (c, d.i, s.i, 4, 0x0f38f1, REPNE | OSO)"));
+	form("crc32", "r32r32", {{"x64w_Gpr32", "d"}, {"x64w_Gpr32", "s"}}, tformat("instr_rr (c, d.i, s.i, 4, 0x0f38f1, REPNE)"));
+	form("crc32", "r64r8",  {{"x64w_Gpr64", "d"}, {"x64w_Gpr8",  "s"}}, tformat("instr_rr8(c, d.i, s.i,    0x0f38f0, REPNE | REXW)"));
+	form("crc32", "r64r64", {{"x64w_Gpr64", "d"}, {"x64w_Gpr64", "s"}}, tformat("instr_rr (c, d.i, s.i, 8, 0x0f38f1, REPNE | REXW)"));
+	form("crc32", "r32m8",  {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 4, 0x0f38f0, REPNE)"));
+	form("crc32", "r32m16", {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 4, 0x0f38f1, REPNE | OSO)"));
+	form("crc32", "r32m32", {{"x64w_Gpr32", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 4, 0x0f38f1, REPNE)"));
+	form("crc32", "r64m8",  {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 8, 0x0f38f0, REPNE | REXW)"));
+	form("crc32", "r64m64", {{"x64w_Gpr64", "d"}, {"x64w_Mem",   "s"}}, tformat("instr_rm (c, d.i,   s, 8, 0x0f38f1, REPNE | REXW)"));
+
+	// xmm and ymm forms need AVX (or `ext`) and are VEX encoded, unless registers 16-31 are used.
+	// zmm forms need AVX-512 and are EVEX encoded.
+	auto V1 = [&](char const *mnem, u32 op, char const *flags, Effects e, Extension ext = ext_avx) {
+		++group;
+		effects = e;
+		extension = ext;
+		form(mnem, "xxx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Xmm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 16, {}, {})", opcode_hex(op), flags));
+		form(mnem, "xxm", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   16, {}, {})", opcode_hex(op), flags));
+		form(mnem, "yyy", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "a"}, {"x64w_Ymm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 32, {}, {})", opcode_hex(op), flags));
+		form(mnem, "yym", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   32, {}, {})", opcode_hex(op), flags));
+		extension = ext_avx512;
+		form(mnem, "zzz", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Zmm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 64, {}, {})", opcode_hex(op), flags));
+		form(mnem, "zzm", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   64, {}, {})", opcode_hex(op), flags));
+		form(mnem, "zzb", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   64, {}, {} | BCST)", opcode_hex(op), flags));
+
+		// Merging keeps masked out elements of the destination.
+		++group;
+		effects = e;
+		effects.access = "xrrr";
+		form(mnem, "zkzz",   {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "a"}, {"x64w_Zmm", "b"}}, tformat("instr_xxxk(c, d.i, a.i, b.i, k.i, 64, {}, {})", opcode_hex(op), flags));
+		form(mnem, "zkzm",   {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxmk(c, d.i, a.i, b,   k.i, 64, {}, {})", opcode_hex(op), flags));
+		form(mnem, "zkzb",   {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxmk(c, d.i, a.i, b,   k.i, 64, {}, {} | BCST)", opcode_hex(op), flags));
+		if (e.access[0] != 'x') effects.access = "wrrr";
+		form(mnem, "zkzz_z", {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "a"}, {"x64w_Zmm", "b"}}, tformat("instr_xxxk(c, d.i, a.i, b.i, k.i, 64, {}, {} | ZEROING)", opcode_hex(op), flags));
+		form(mnem, "zkzm_z", {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxmk(c, d.i, a.i, b,   k.i, 64, {}, {} | ZEROING)", opcode_hex(op), flags));
+		form(mnem, "zkzb_z", {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxmk(c, d.i, a.i, b,   k.i, 64, {}, {} | ZEROING | BCST)", opcode_hex(op), flags));
+	};
+
+	// Same with an 8-bit immediate.
+	auto V2 = [&](char const *mnem, u32 op, char const *flags, Effects e, Extension ext = ext_avx) {
+		++group;
+		effects = e;
+		extension = ext;
+		form(mnem, "xxxi", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Xmm", "b"}, {"uint8_t", "i"}}, tformat("instr_xxxi(c, d.i, a.i, b.i, i, 16, {}, {})", opcode_hex(op), flags));
+		form(mnem, "xxmi", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Mem", "b"}, {"uint8_t", "i"}}, tformat("instr_xxmi(c, d.i, a.i, b,   i, 16, {}, {})", opcode_hex(op), flags));
+		form(mnem, "yyyi", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "a"}, {"x64w_Ymm", "b"}, {"uint8_t", "i"}}, tformat("instr_xxxi(c, d.i, a.i, b.i, i, 32, {}, {})", opcode_hex(op), flags));
+		form(mnem, "yymi", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "a"}, {"x64w_Mem", "b"}, {"uint8_t", "i"}}, tformat("instr_xxmi(c, d.i, a.i, b,   i, 32, {}, {})", opcode_hex(op), flags));
+		extension = ext_avx512;
+		form(mnem, "zzzi", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Zmm", "b"}, {"uint8_t", "i"}}, tformat("instr_xxxi(c, d.i, a.i, b.i, i, 64, {}, {})", opcode_hex(op), flags));
+		form(mnem, "zzmi", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}, {"uint8_t", "i"}}, tformat("instr_xxmi(c, d.i, a.i, b,   i, 64, {}, {})", opcode_hex(op), flags));
+	};
+
+	// Packed double and quadword instructions set W only in EVEX.
+	V1("vaddps",  0x0f58, "0",           {.access = "wrr"});
+	V1("vaddpd",  0x0f58, "OSO | EVEXW", {.access = "wrr"});
+	V1("vsubps",  0x0f5c, "0",           {.access = "wrr"});
+	V1("vsubpd",  0x0f5c, "OSO | EVEXW", {.access = "wrr"});
+	V1("vmulps",  0x0f59, "0",           {.access = "wrr"});
+	V1("vmulpd",  0x0f59, "OSO | EVEXW", {.access = "wrr"});
+	V1("vdivps",  0x0f5e, "0",           {.access = "wrr"});
+	V1("vdivpd",  0x0f5e, "OSO | EVEXW", {.access = "wrr"});
+	V1("vminps",  0x0f5d, "0",           {.access = "wrr"});
+	V1("vminpd",  0x0f5d, "OSO | EVEXW", {.access = "wrr"});
+	V1("vmaxps",  0x0f5f, "0",           {.access = "wrr"});
+	V1("vmaxpd",  0x0f5f, "OSO | EVEXW", {.access = "wrr"});
+	V1("vpaddd",  0x0ffe, "OSO",         {.access = "wrr"});
+	V1("vpaddq",  0x0fd4, "OSO | EVEXW", {.access = "wrr"});
+	V1("vpsubd",  0x0ffa, "OSO",         {.access = "wrr"});
+	V1("vpsubq",  0x0ffb, "OSO | EVEXW", {.access = "wrr"});
+	V1("vpmulld", 0x0f3840, "OSO",       {.access = "wrr"});
+	V2("vshufps", 0x0fc6, "0",           {.access = "wrrr"});
+	V2("vshufpd", 0x0fc6, "OSO | EVEXW", {.access = "wrrr"});
+
+	// W is set in both encodings. There is no xmm form and no second source.
+	++group;
+	extension = ext_avx;
+	effects = {.access = "wrr"};
+	form("vpermq", "yyi", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "s"}, {"uint8_t", "i"}}, tformat("instr_xxxi(c, d.i, 0, s.i, i, 32, 0x0f3a00, OSO | REXW)"));
+	form("vpermq", "ymi", {{"x64w_Ymm", "d"}, {"x64w_Mem", "s"}, {"uint8_t", "i"}}, tformat("instr_xxmi(c, d.i, 0,   s, i, 32, 0x0f3a00, OSO | REXW)"));
+	extension = ext_avx512;
+	form("vpermq", "zzi", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "s"}, {"uint8_t", "i"}}, tformat("instr_xxxi(c, d.i, 0, s.i, i, 64, 0x0f3a00, OSO | REXW)"));
+	form("vpermq", "zmi", {{"x64w_Zmm", "d"}, {"x64w_Mem", "s"}, {"uint8_t", "i"}}, tformat("instr_xxmi(c, d.i, 0,   s, i, 64, 0x0f3a00, OSO | REXW)"));
+
+	++group;
+	extension = ext_avx;
+	effects = {.access = "wr"};
+	form("vmovntdq", "mx", {{"x64w_Mem", "d"}, {"x64w_Xmm", "s"}}, tformat("instr_xxm(c, s.i, 0, d, 16, 0x0fe7, OSO)"));
+	form("vmovntdq", "my", {{"x64w_Mem", "d"}, {"x64w_Ymm", "s"}}, tformat("instr_xxm(c, s.i, 0, d, 32, 0x0fe7, OSO)"));
+	extension = ext_avx512;
+	form("vmovntdq", "mz", {{"x64w_Mem", "d"}, {"x64w_Zmm", "s"}}, tformat("instr_xxm(c, s.i, 0, d, 64, 0x0fe7, OSO)"));
+
+	// Fused multiply-add, the digits give the order of operands:
+	// 132 is d = d * b + a, 213 is d = a * d + b, 231 is d = a * b + d.
+	// Scalar forms are xmm only and their memory operand is one element.
+	struct E6 {
+		char const *mnem[4]; // ps, pd, ss, sd
+		u8 op;
+	};
+	E6 fmas[] = {
+		{{"vfmadd132ps",  "vfmadd132pd",  "vfmadd132ss",  "vfmadd132sd"},  0x98},
+		{{"vfmadd213ps",  "vfmadd213pd",  "vfmadd213ss",  "vfmadd213sd"},  0xa8},
+		{{"vfmadd231ps",  "vfmadd231pd",  "vfmadd231ss",  "vfmadd231sd"},  0xb8},
+		{{"vfmsub132ps",  "vfmsub132pd",  "vfmsub132ss",  "vfmsub132sd"},  0x9a},
+		{{"vfmsub213ps",  "vfmsub213pd",  "vfmsub213ss",  "vfmsub213sd"},  0xaa},
+		{{"vfmsub231ps",  "vfmsub231pd",  "vfmsub231ss",  "vfmsub231sd"},  0xba},
+		{{"vfnmadd132ps", "vfnmadd132pd", "vfnmadd132ss", "vfnmadd132sd"}, 0x9c},
+		{{"vfnmadd213ps", "vfnmadd213pd", "vfnmadd213ss", "vfnmadd213sd"}, 0xac},
+		{{"vfnmadd231ps", "vfnmadd231pd", "vfnmadd231ss", "vfnmadd231sd"}, 0xbc},
+		{{"vfnmsub132ps", "vfnmsub132pd", "vfnmsub132ss", "vfnmsub132sd"}, 0x9e},
+		{{"vfnmsub213ps", "vfnmsub213pd", "vfnmsub213ss", "vfnmsub213sd"}, 0xae},
+		{{"vfnmsub231ps", "vfnmsub231pd", "vfnmsub231ss", "vfnmsub231sd"}, 0xbe},
+	};
+	for (auto e : fmas) {
+		V1(e.mnem[0], 0x0f3800 | e.op, "OSO",        {.access = "xrr"}, ext_fma);
+		V1(e.mnem[1], 0x0f3800 | e.op, "OSO | REXW", {.access = "xrr"}, ext_fma);
+
+		++group;
+		extension = ext_fma;
+		effects = {.access = "xrr"};
+		form(e.mnem[2], "xxx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Xmm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 16, {}, OSO | T1S)",        opcode_hex(0x0f3801 | e.op)));
+		form(e.mnem[2], "xxm", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   16, {}, OSO | T1S)",        opcode_hex(0x0f3801 | e.op)));
+		form(e.mnem[3], "xxx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Xmm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 16, {}, OSO | REXW | T1S)", opcode_hex(0x0f3801 | e.op)));
+		form(e.mnem[3], "xxm", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   16, {}, OSO | REXW | T1S)", opcode_hex(0x0f3801 | e.op)));
+	}
+
+	// AES-NI, PCLMULQDQ and SHA. Each AES instruction does one round on a 128-bit block,
+	// wide forms do the same round on every 128-bit lane (VAES, VPCLMULQDQ).
+	extension = ext_crypto;
+
+	I7("aesenc",           0x0f38dc, "OSO", {.access = "xr"});
+	I7("aesenclast",       0x0f38dd, "OSO", {.access = "xr"});
+	I7("aesdec",           0x0f38de, "OSO", {.access = "xr"});
+	I7("aesdeclast",       0x0f38df, "OSO", {.access = "xr"});
+	I7("aesimc",           0x0f38db, "OSO", {.access = "wr"});
+	I11("aeskeygenassist", 0x0f3adf, "OSO", {.access = "wrr"});
+	I11("pclmulqdq",       0x0f3a44, "OSO", {.access = "xrr"});
+	I7("sha1nexte",        0x0f38c8, "0",   {.access = "xr"});
+	I7("sha1msg1",         0x0f38c9, "0",   {.access = "xr"});
+	I7("sha1msg2",         0x0f38ca, "0",   {.access = "xr"});
+	I7("sha256rnds2",      0x0f38cb, "0",   {.access = "xr", .implicit_vector_read = XMM0});
+	I7("sha256msg1",       0x0f38cc, "0",   {.access = "xr"});
+	I7("sha256msg2",       0x0f38cd, "0",   {.access = "xr"});
+	I11("sha1rnds4",       0x0f3acc, "0",   {.access = "xrr"});
+
+	// Wide AES forms can't be masked or broadcast
+	auto V3 = [&](char const *mnem, u32 op) {
+		++group;
+		effects = {.access = "wrr"};
+		extension = ext_crypto;
+		form(mnem, "xxx", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Xmm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 16, {}, OSO)", opcode_hex(op)));
+		form(mnem, "xxm", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   16, {}, OSO)", opcode_hex(op)));
+		form(mnem, "yyy", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "a"}, {"x64w_Ymm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 32, {}, OSO)", opcode_hex(op)));
+		form(mnem, "yym", {{"x64w_Ymm", "d"}, {"x64w_Ymm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   32, {}, OSO)", opcode_hex(op)));
+		extension = ext_avx512;
+		form(mnem, "zzz", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Zmm", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 64, {}, OSO)", opcode_hex(op)));
+		form(mnem, "zzm", {{"x64w_Zmm", "d"}, {"x64w_Zmm", "a"}, {"x64w_Mem", "b"}}, tformat("instr_xxm(c, d.i, a.i, b,   64, {}, OSO)", opcode_hex(op)));
+	};
+
+	V3("vaesenc",     0x0f38dc);
+	V3("vaesenclast", 0x0f38dd);
+	V3("vaesdec",     0x0f38de);
+	V3("vaesdeclast", 0x0f38df);
+	V2("vpclmulqdq",  0x0f3a44, "OSO", {.access = "wrrr"}, ext_crypto);
+
+	// Key schedule helpers have only the VEX xmm form
+	++group;
+	extension = ext_crypto;
+	effects = {.access = "wr"};
+	form("vaesimc",          "xx",  {{"x64w_Xmm", "d"}, {"x64w_Xmm", "s"}},                   tformat("instr_vrr(c,  d.i, 0, s.i,    16, 0x0f38db, OSO)"));
+	form("vaesimc",          "xm",  {{"x64w_Xmm", "d"}, {"x64w_Mem", "s"}},                   tformat("instr_vrm(c,  d.i, 0,   s,    16, 0x0f38db, OSO)"));
+	effects = {.access = "wrr"};
+	form("vaeskeygenassist", "xxi", {{"x64w_Xmm", "d"}, {"x64w_Xmm", "s"}, {"uint8_t", "i"}}, tformat("instr_vrri(c, d.i,    s.i, i, 16, 0x0f3adf, OSO)"));
+	form("vaeskeygenassist", "xmi", {{"x64w_Xmm", "d"}, {"x64w_Mem", "s"}, {"uint8_t", "i"}}, tformat("instr_vrmi(c, d.i,      s, i, 16, 0x0f3adf, OSO)"));
+
+	// Gathers and scatters address elements with a vector index (VSIB).
+	// VEX encoded gathers are masked by sign bits of a vector, EVEX ones by an opmask,
+	// the mask is cleared as elements complete. Scatters are AVX-512 only, opcode is gather's + 0x10.
+	// Index has as many elements as data, so with qword data and dword index it is half the size.
+	auto G1 = [&](char const *gather, char const *scatter, u32 op, char const *flags, bool half_index) {
+		auto index = [&](unsigned size) { return half_index && size > 16 ? size / 2 : size; };
+		++group;
+		extension = ext_avx;
+		effects = {.access = "xrx"};
+		form(gather, "xvx", {{"x64w_Xmm", "d"}, {"x64w_Vsib", "m"}, {"x64w_Xmm", "v"}}, tformat("instr_gather(c, d.i, m, v.i, 16, {}, {}, {})", index(16), opcode_hex(op), flags));
+		form(gather, "yvy", {{"x64w_Ymm", "d"}, {"x64w_Vsib", "m"}, {"x64w_Ymm", "v"}}, tformat("instr_gather(c, d.i, m, v.i, 32, {}, {}, {})", index(32), opcode_hex(op), flags));
+
+		++group;
+		extension = ext_avx512;
+		effects = {.access = "xxr"};
+		form(gather, "xkv", {{"x64w_Xmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Vsib", "m"}}, tformat("instr_gatherk(c, d.i, k.i, m, 16, {}, {}, {})", index(16), opcode_hex(op), flags));
+		form(gather, "ykv", {{"x64w_Ymm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Vsib", "m"}}, tformat("instr_gatherk(c, d.i, k.i, m, 32, {}, {}, {})", index(32), opcode_hex(op), flags));
+		form(gather, "zkv", {{"x64w_Zmm", "d"}, {"x64w_Kreg", "k"}, {"x64w_Vsib", "m"}}, tformat("instr_gatherk(c, d.i, k.i, m, 64, {}, {}, {})", index(64), opcode_hex(op), flags));
+
+		++group;
+		effects = {.access = "wxr"};
+		form(scatter, "vkx", {{"x64w_Vsib", "m"}, {"x64w_Kreg", "k"}, {"x64w_Xmm", "s"}}, tformat("instr_scatterk(c, m, k.i, s.i, 16, {}, {}, {})", index(16), opcode_hex(op + 0x10), flags));
+		form(scatter, "vky", {{"x64w_Vsib", "m"}, {"x64w_Kreg", "k"}, {"x64w_Ymm", "s"}}, tformat("instr_scatterk(c, m, k.i, s.i, 32, {}, {}, {})", index(32), opcode_hex(op + 0x10), flags));
+		form(scatter, "vkz", {{"x64w_Vsib", "m"}, {"x64w_Kreg", "k"}, {"x64w_Zmm", "s"}}, tformat("instr_scatterk(c, m, k.i, s.i, 64, {}, {}, {})", index(64), opcode_hex(op + 0x10), flags));
+	};
+	G1("vpgatherdd", "vpscatterdd", 0x0f3890, "OSO",        false);
+	G1("vpgatherqq", "vpscatterqq", 0x0f3891, "OSO | REXW", false);
+	G1("vgatherdps", "vscatterdps", 0x0f3892, "OSO",        false);
+	G1("vgatherdpd", "vscatterdpd", 0x0f3892, "OSO | REXW", true);
+
+	// Opmask instructions are VEX encoded. Size of the mask is selected by pp and W:
+	// b - 66.W0, w - W0, d - 66.W1, q - W1
+	char const *mask_flags[4] = {"OSO", "0", "OSO | REXW", "REXW"};
+
+	// k, k, k. These have VEX.L set.
+	auto K1 = [&](char const *b, char const *w, char const *d, char const *q, u16 op) {
+		++group;
+		effects = {.access = "wrr"};
+		char const *mnems[4] = {b, w, d, q};
+		for (int i = 0; i < 4; ++i) {
+			form(mnems[i], "kkk", {{"x64w_Kreg", "d"}, {"x64w_Kreg", "a"}, {"x64w_Kreg", "b"}}, tformat("instr_xxx(c, d.i, a.i, b.i, 32, {}, {})", hex(op), mask_flags[i]));
+		}
+	};
+
+	extension = ext_avx512;
+	K1("kandb",  "kandw",  "kandd",  "kandq",  0x0f41);
+	K1("kandnb", "kandnw", "kandnd", "kandnq", 0x0f42);
+	K1("korb",   "korw",   "kord",   "korq",   0x0f45);
+	K1("kxorb",  "kxorw",  "kxord",  "kxorq",  0x0f47);
+
+	++group;
+	effects = {.access = "wr"};
+	form("knotb", "kk", {{"x64w_Kreg", "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f44, OSO)"));
+	form("knotw", "kk", {{"x64w_Kreg", "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f44, 0)"));
+	form("knotd", "kk", {{"x64w_Kreg", "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f44, OSO | REXW)"));
+	form("knotq", "kk", {{"x64w_Kreg", "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f44, REXW)"));
+
+	// ZF is set if the OR is all zeros, CF if it is all ones.
+	++group;
+	effects = {.access = "rr", .flags_written = STATUS};
+	form("kortestb", "kk", {{"x64w_Kreg", "a"}, {"x64w_Kreg", "b"}}, tformat("instr_xxx(c, a.i, 0, b.i, 16, 0x0f98, OSO)"));
+	form("kortestw", "kk", {{"x64w_Kreg", "a"}, {"x64w_Kreg", "b"}}, tformat("instr_xxx(c, a.i, 0, b.i, 16, 0x0f98, 0)"));
+	form("kortestd", "kk", {{"x64w_Kreg", "a"}, {"x64w_Kreg", "b"}}, tformat("instr_xxx(c, a.i, 0, b.i, 16, 0x0f98, OSO | REXW)"));
+	form("kortestq", "kk", {{"x64w_Kreg", "a"}, {"x64w_Kreg", "b"}}, tformat("instr_xxx(c, a.i, 0, b.i, 16, 0x0f98, REXW)"));
+
+	// Moves to and from general purpose registers use F2 instead of 66 for 32 and 64-bit masks.
+	auto K2 = [&](char const *mnem, char const *flags, char const *gpr_flags, char const *gpr) {
+		++group;
+		effects = {.access = "wr"};
+		form(mnem, "kk", {{"x64w_Kreg", "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f90, {})", flags));
+		form(mnem, "km", {{"x64w_Kreg", "d"}, {"x64w_Mem",  "s"}}, tformat("instr_xxm(c, d.i, 0,   s, 16, 0x0f90, {})", flags));
+		form(mnem, "mk", {{"x64w_Mem",  "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxm(c, s.i, 0,   d, 16, 0x0f91, {})", flags));
+		form(mnem, "kr", {{"x64w_Kreg", "d"}, {gpr,         "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f92, {})", gpr_flags));
+		form(mnem, "rk", {{gpr,         "d"}, {"x64w_Kreg", "s"}}, tformat("instr_xxx(c, d.i, 0, s.i, 16, 0x0f93, {})", gpr_flags));
+	};
+
+	K2("kmovb", "OSO",        "OSO",          "x64w_Gpr32");
+	K2("kmovw", "0",          "0",            "x64w_Gpr32");
+	K2("kmovd", "OSO | REXW", "REPNE",        "x64w_Gpr32");
+	K2("kmovq", "REXW",       "REPNE | REXW", "x64w_Gpr64");
+
+	//
+	// Emit the forms, section by section.
+	//
+
+	struct GroupWidths {
+		umm name;
+		umm types[4];
+	};
+	List<GroupWidths> group_widths;
+	for (u32 i = 0; i <= group; ++i) {
+		group_widths.add({});
+	}
+	for (auto &f : forms) {
+		auto &w = group_widths[f.group];
+		w.name = max(w.name, f.name.count);
+		for (umm i = 0; i < f.params.count; ++i) {
+			w.types[i] = max(w.types[i], (umm)strlen(f.params[i].type));
+		}
+	}
+
+	auto append_padded = [&](StringBuilder &builder, Span<char> string, umm width) {
+		append(builder, string);
+		for (umm i = string.count; i < width; ++i) {
+			append(builder, ' ');
+		}
+	};
+
+	auto append_signature = [&](StringBuilder &builder, Form &f) {
+		auto &w = group_widths[f.group];
+		append(builder, "x64w_Result x64w_");
+		append_padded(builder, f.name, w.name);
+		append(builder, "(uint8_t **c");
+		for (umm i = 0; i < f.params.count; ++i) {
+			append(builder, ", ");
+			append_padded(builder, as_span(f.params[i].type), w.types[i]);
+			append_format(builder, " {}", f.params[i].name);
+		}
+		append(builder, ")");
+	};
+
+	// Builds an argument for x64w_<name> from x64w_Operand
+	auto append_operand = [&](StringBuilder &builder, Param param, umm index) {
+		if (as_span(param.type) == "x64w_Mem"s) {
+			append_format(builder, "o[{}].m", index);
+		} else if (as_span(param.type) == "x64w_Vsib"s) {
+			append_format(builder, "o[{}].v", index);
+		} else if (as_span(param.type) == "x64w_Cond"s) {
+			append_format(builder, "(x64w_Cond)o[{}].i", index);
+		} else if (starts_with(as_span(param.type), "x64w_"s)) {
+			append_format(builder, "X64W_LIT({}){{o[{}].r}}", param.type, index);
+		} else {
+			append_format(builder, "({})o[{}].i", param.type, index);
+		}
+	};
+
+	auto operand_kind = [&](Param param) -> char const * {
+		auto type = as_span(param.type);
+		if (type == "x64w_Gpr8"s)  return "x64w_kind_gpr8";
+		if (type == "x64w_Gpr16"s) return "x64w_kind_gpr16";
+		if (type == "x64w_Gpr32"s) return "x64w_kind_gpr32";
+		if (type == "x64w_Gpr64"s) return "x64w_kind_gpr64";
+		if (type == "x64w_Xmm"s)   return "x64w_kind_xmm";
+		if (type == "x64w_Ymm"s)   return "x64w_kind_ymm";
+		if (type == "x64w_Zmm"s)   return "x64w_kind_zmm";
+		if (type == "x64w_Kreg"s)  return "x64w_kind_kreg";
+		if (type == "x64w_Mem"s)   return "x64w_kind_mem";
+		if (type == "x64w_Vsib"s)  return "x64w_kind_vsib";
+		if (type == "x64w_Cond"s)  return "x64w_kind_cond";
+		if (type == "int8_t"s  || type == "uint8_t"s)  return "x64w_kind_imm8";
+		if (type == "int16_t"s || type == "uint16_t"s) return "x64w_kind_imm16";
+		if (type == "int32_t"s || type == "uint32_t"s) return "x64w_kind_imm32";
+		if (type == "int64_t"s || type == "uint64_t"s) return "x64w_kind_imm64";
+		assert(false, "unknown operand type");
+		return 0;
+	};
+
+	auto operand_access = [&](char access) -> char const * {
+		switch (access) {
+			case 'n': return "x64w_access_none";
+			case 'r': return "x64w_access_read";
+			case 'w': return "x64w_access_write";
+			case 'x': return "x64w_access_read_write";
+		}
+		assert(false, "unknown operand access");
+		return 0;
+	};
+
+	// Appends `mask` as a combination of `names`, where names[i] corresponds to bit i.
+	auto append_mask = [&](StringBuilder &builder, u16 mask, char const *const *names) {
+		if (!mask) {
+			append(builder, "0");
+			return;
+		}
+		bool first = true;
+		for (u32 i = 0; i < 16; ++i) {
+			if (mask & (1 << i)) {
+				if (!first) {
+					append(builder, " | ");
+				}
+				append(builder, names[i]);
+				first = false;
+			}
+		}
+	};
+
+	char const *register_masks[16] = {
+		"x64w_mask_rax", "x64w_mask_rcx", "x64w_mask_rdx", "x64w_mask_rbx",
+		"x64w_mask_rsp", "x64w_mask_rbp", "x64w_mask_rsi", "x64w_mask_rdi",
+		"x64w_mask_r8",  "x64w_mask_r9",  "x64w_mask_r10", "x64w_mask_r11",
+		"x64w_mask_r12", "x64w_mask_r13", "x64w_mask_r14", "x64w_mask_r15",
+	};
+	char const *vector_masks[16] = {
+		"x64w_mask_xmm0",  "x64w_mask_xmm1",  "x64w_mask_xmm2",  "x64w_mask_xmm3",
+		"x64w_mask_xmm4",  "x64w_mask_xmm5",  "x64w_mask_xmm6",  "x64w_mask_xmm7",
+		"x64w_mask_xmm8",  "x64w_mask_xmm9",  "x64w_mask_xmm10", "x64w_mask_xmm11",
+		"x64w_mask_xmm12", "x64w_mask_xmm13", "x64w_mask_xmm14", "x64w_mask_xmm15",
+	};
+	char const *flag_masks[16] = {
+		"x64w_flag_cf", 0, "x64w_flag_pf", 0, "x64w_flag_af", 0, "x64w_flag_zf", "x64w_flag_sf",
+		0, 0, "x64w_flag_df", "x64w_flag_of", 0, 0, 0, 0,
+	};
+
+	append(form_enum, "typedef enum x64w_Form X64W_UNDERLYING(uint16_t) {\n");
+	append(form_infos, "static x64w_FormInfo const x64w_form_infos[x64w_form_count] = {\n");
+	append(encoder_table, "static x64w_Encoder const x64w_encoders[x64w_form_count] = {\n");
+
+	for (u32 ext = 0; ext < ext_count; ++ext) {
+		if (ext != ext_base) {
+			append_format(function_declarations,     "\n#if {}\n", extension_guards[ext]);
+			append_format(function_definitions,      "\n#if {}\n", extension_guards[ext]);
+			append_format(function_prefix_strippers, "\n#if {}\n", extension_guards[ext]);
+			append_format(encoders,                  "\n#if {}\n", extension_guards[ext]);
+			append_format(encoder_table,             "#if {}\n",   extension_guards[ext]);
+		}
+
+		for (auto &f : forms) {
+			if (f.extension != ext)
+				continue;
+
+			append(function_declarations, "X64W_DEF ");
+			append_signature(function_declarations, f);
+			append(function_declarations, ";\n");
+
+			append_signature(function_definitions, f);
+			append(function_definitions, " { ");
+			// Conditions and opmask registers are not checked by instr_* functions.
+			// Neither are the register classes that can't use the REX2/EVEX high
+			// register bits in a given encoding: xmm16-31 in legacy forms and
+			// r16-r31 in EVEX forms.
+			bool has_restore = false;
+			bool is_legacy = starts_with(f.body, "instr_r"s) || starts_with(f.body, "instr_m"s);
+			bool is_evex   = starts_with(f.body, "instr_x"s);
+			for (auto param : f.params) {
+				char const *validate = 0;
+				if (as_span(param.type) == "x64w_Cond"s) validate = "X64W_VALIDATE_CC({}); ";
+				if (as_span(param.type) == "x64w_Kreg"s) validate = "X64W_VALIDATE_K({}.i); ";
+				if (is_legacy && as_span(param.type) == "x64w_Xmm"s) validate = "X64W_VALIDATE_LOW({}.i); ";
+				if (is_evex && starts_with(as_span(param.type), "x64w_Gpr"s)) validate = "X64W_VALIDATE_LOW({}.i); ";
+				if (validate) {
+					if (!has_restore) {
+						append(function_definitions, "uint8_t *restore = *c; ");
+						has_restore = true;
+					}
+					append_format(function_definitions, validate, param.name);
+				}
+			}
+			append_format(function_definitions, "return {}; }}\n", f.body);
+
+			append(function_prefix_strippers, "#define ");
+			append_padded(function_prefix_strippers, f.name, group_widths[f.group].name);
+			append_format(function_prefix_strippers, " x64w_{}\n", f.name);
+
+			append_format(form_enum, "\tx64w_form_{},\n", f.name);
+
+			append(encoders, "static x64w_Result x64w_encode_");
+			append_padded(encoders, f.name, group_widths[f.group].name);
+			append(encoders, "(uint8_t **c, x64w_Operand const *o) { ");
+			if (f.params.count == 0) {
+				append(encoders, "(void)o; ");
+			}
+			append_format(encoders, "return x64w_{}(c", f.name);
+			for (umm i = 0; i < f.params.count; ++i) {
+				append(encoders, ", ");
+				append_operand(encoders, f.params[i], i);
+			}
+			append(encoders, "); }\n");
+
+			append_format(encoder_table, "\tx64w_encode_{},\n", f.name);
+
+			// Metadata is not guarded: it is available for forms of disabled extensions too.
+			auto &e = f.effects;
+			assert(strlen(e.access) >= f.params.count, "access is not specified for every operand");
+			append_format(form_infos, "\t/* {} */ {{\"{}\", {}, {{", f.name, f.mnem, f.params.count);
+			for (umm i = 0; i < f.params.count; ++i) {
+				append_format(form_infos, "{}{}", i ? ", " : "", operand_kind(f.params[i]));
+			}
+			// Empty initializer lists are not allowed in C
+			if (f.params.count == 0) {
+				append(form_infos, "0");
+			}
+			append(form_infos, "}, {");
+			for (umm i = 0; i < f.params.count; ++i) {
+				append_format(form_infos, "{}{}", i ? ", " : "", operand_access(e.access[i]));
+			}
+			if (f.params.count == 0) {
+				append(form_infos, "0");
+			}
+			append(form_infos, "}, ");
+			append_mask(form_infos, e.implicit_read, register_masks);
+			append(form_infos, ", ");
+			append_mask(form_infos, e.implicit_write, register_masks);
+			append(form_infos, ", ");
+			append_mask(form_infos, e.implicit_vector_read, vector_masks);
+			append(form_infos, ", ");
+			append_mask(form_infos, e.implicit_vector_write, vector_masks);
+			append(form_infos, ", ");
+			append_mask(form_infos, e.flags_read, flag_masks);
+			append(form_infos, ", ");
+			append_mask(form_infos, e.flags_written, flag_masks);
+			append(form_infos, ", ");
+			append_mask(form_infos, e.flags_undefined, flag_masks);
+			append(form_infos, "},\n");
+		}
+
+		if (ext != ext_base) {
+			append_format(function_declarations,     "#endif // {}\n", extension_guards[ext]);
+			append_format(function_definitions,      "#endif // {}\n", extension_guards[ext]);
+			append_format(function_prefix_strippers, "#endif // {}\n", extension_guards[ext]);
+			append_format(encoders,                  "#endif // {}\n", extension_guards[ext]);
+
+			// Keep indices of the following forms intact when extension is disabled.
+			append(encoder_table, "#else\n");
+			for (auto &f : forms) {
+				if (f.extension == ext) {
+					append(encoder_table, "\t0,\n");
+				}
+			}
+			append_format(encoder_table, "#endif // {}\n", extension_guards[ext]);
+		}
+	}
+
+	append(form_enum, "\tx64w_form_count,\n");
+	append(form_enum, "} x64w_Form;\n");
+	append(encoder_table, "};\n");
+	append(form_infos, "};\n");
+	append(encoders, "\n");
+	append(encoders, to_string(encoder_table));
 
 	auto templatee = to_list((Span<char>)read_entire_file(tformat("{}\\x64write.template.h", root_directory)));
 
@@ -263,6 +1374,9 @@ s32 tl_main(Span<String> args) {
 		{"INSERT_FUNCTION_DECLARATIONS"s,     &function_declarations    },
 		{"INSERT_FUNCTION_DEFINITIONS"s,      &function_definitions     },
 		{"INSERT_FUNCTION_PREFIX_STRIPPERS"s, &function_prefix_strippers},
+		{"INSERT_FORMS"s,                     &form_enum                },
+		{"INSERT_ENCODERS"s,                  &encoders                 },
+		{"INSERT_FORM_INFOS"s,                &form_infos               },
 	};
 
 	for (auto &inserter : inserters) {
@@ -22,8 +22,11 @@ inline void append(StringBuilder &builder, Gpr64 r) { append(builder, regnames64
 inline void append(StringBuilder &builder, Xmm r) { append_format(builder, "xmm{}", r.i); }
 inline void append(StringBuilder &builder, Ymm r) { append_format(builder, "ymm{}", r.i); }
 inline void append(StringBuilder &builder, Zmm r) { append_format(builder, "zmm{}", r.i); }
+inline void append(StringBuilder &builder, Kreg r) { append_format(builder, "k{}", r.i); }
 
 inline void append(StringBuilder &builder, Mem m) {
+	if (m.segment == seg_fs) append(builder, "fs:");
+	if (m.segment == seg_gs) append(builder, "gs:");
 	append(builder, '[');
 	if (m.base_scale) {
 		if (m.size_override)
@@ -52,6 +55,25 @@ inline void append(StringBuilder &builder, Mem m) {
 	append(builder, ']');
 }
 
+// `index` is the register name without a number, parsed Vsib doesn't know size of its index.
+inline void append_vsib(StringBuilder &builder, Vsib m, char const *index) {
+	append(builder, '[');
+	if (m.base_scale) {
+		if (m.size_override)
+			append(builder, Gpr32{m.base});
+		else
+			append(builder, Gpr64{m.base});
+		append(builder, '+');
+	}
+	append_format(builder, "{}{}*{}", index, m.index, m.index_scale);
+	if (m.displacement) {
+		append(builder, '+');
+		append(builder, m.displacement);
+	}
+	append(builder, ']');
+}
+inline void append(StringBuilder &builder, Vsib m) { append_vsib(builder, m, "vmm"); }
+
 // Microsoft 64 bit calling convention - saved registers
 // +-----+----------+
 // | reg | volatile |
@@ -131,7 +153,7 @@ void write_instructions_to_obj(Span<u8> instructions, Span<utf8> filename) {
     write_entire_file(filename, bytes);
 }
 
-using Operand = Variant<Gpr8, Gpr16, Gpr32, Gpr64, Xmm, Ymm, Zmm, Mem, s64>;
+using Operand = Variant<Gpr8, Gpr16, Gpr32, Gpr64, Xmm, Ymm, Zmm, Kreg, Mem, Vsib, s64>;
 		
 struct InstrDesc {
 	String mnemonic;
@@ -168,7 +190,7 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 	line.set_begin(first_space);
 	line = trim(line, [](auto x) { return is_whitespace((ascii)x); });
 
-	auto parse_any_register = [&]() -> Variant<Empty, Gpr8, Gpr16, Gpr32, Gpr64, Xmm, Ymm, Zmm> {
+	auto parse_any_register = [&]() -> Variant<Empty, Gpr8, Gpr16, Gpr32, Gpr64, Xmm, Ymm, Zmm, Kreg> {
 		
 		switch (*(u64 *)line.data & 0xffffffffff) {
 			case 'x' | ('m'<<8) | ('m'<<16) | ('1'<<24) | ((u64)'0'<<32): line.data += 5; line.count -= 5; return xmm10;
@@ -295,6 +317,14 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 			case 'd'|('i'<<8): line.data += 2; line.count -= 2; return di;
 			case 'r'|('8'<<8): line.data += 2; line.count -= 2; return r8;
 			case 'r'|('9'<<8): line.data += 2; line.count -= 2; return r9;
+			case 'k'|('0'<<8): line.data += 2; line.count -= 2; return k0;
+			case 'k'|('1'<<8): line.data += 2; line.count -= 2; return k1;
+			case 'k'|('2'<<8): line.data += 2; line.count -= 2; return k2;
+			case 'k'|('3'<<8): line.data += 2; line.count -= 2; return k3;
+			case 'k'|('4'<<8): line.data += 2; line.count -= 2; return k4;
+			case 'k'|('5'<<8): line.data += 2; line.count -= 2; return k5;
+			case 'k'|('6'<<8): line.data += 2; line.count -= 2; return k6;
+			case 'k'|('7'<<8): line.data += 2; line.count -= 2; return k7;
 		}
 
 		return {};
@@ -311,6 +341,17 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 		return {};
 	};
 
+	// Index of gathers and scatters. Its size is not compared, it is determined by the form.
+	auto parse_vector_index = [&]() -> Optional<u8> {
+		auto prev = line;
+		auto reg = parse_any_register();
+		if (reg.is<Xmm>()) return reg.as<Xmm>().value().i;
+		if (reg.is<Ymm>()) return reg.as<Ymm>().value().i;
+		if (reg.is<Zmm>()) return reg.as<Zmm>().value().i;
+		line = prev;
+		return {};
+	};
+
 	int size = 0;
 
 	while (line.count) {
@@ -328,20 +369,41 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 				[&](Gpr64) {size = 8;},
 			});
 		} else if (
-			(starts_with(line, u8"byte ptr ["s)    && (line.set_begin(line.begin() + 10), size = 1, true)) ||
-			(starts_with(line, u8"word ptr ["s)    && (line.set_begin(line.begin() + 10), size = 2, true)) ||
-			(starts_with(line, u8"dword ptr ["s)   && (line.set_begin(line.begin() + 11), size = 4, true)) ||
-			(starts_with(line, u8"qword ptr ["s)   && (line.set_begin(line.begin() + 11), size = 8, true)) ||
-			(starts_with(line, u8"xmmword ptr ["s) && (line.set_begin(line.begin() + 13), size = 16, true)) ||
-			(starts_with(line, u8"ymmword ptr ["s) && (line.set_begin(line.begin() + 13), size = 32, true)) ||
-			(starts_with(line, u8"zmmword ptr ["s) && (line.set_begin(line.begin() + 13), size = 64, true)) ||
-			(starts_with(line, u8"["s)             && (line.set_begin(line.begin() +  1),            true))
+			(starts_with(line, u8"byte ptr "s)    && (line.set_begin(line.begin() +  9), size = 1, true)) ||
+			(starts_with(line, u8"word ptr "s)    && (line.set_begin(line.begin() +  9), size = 2, true)) ||
+			(starts_with(line, u8"dword ptr "s)   && (line.set_begin(line.begin() + 10), size = 4, true)) ||
+			(starts_with(line, u8"qword ptr "s)   && (line.set_begin(line.begin() + 10), size = 8, true)) ||
+			(starts_with(line, u8"xmmword ptr "s) && (line.set_begin(line.begin() + 12), size = 16, true)) ||
+			(starts_with(line, u8"ymmword ptr "s) && (line.set_begin(line.begin() + 12), size = 32, true)) ||
+			(starts_with(line, u8"zmmword ptr "s) && (line.set_begin(line.begin() + 12), size = 64, true)) ||
+			starts_with(line, u8"["s)
 		) {
 			Mem m = {};
+			Optional<u8> vector_index;
+
+			if (starts_with(line, u8"fs:"s)) { m.segment = seg_fs; line.set_begin(line.begin() + 3); }
+			if (starts_with(line, u8"gs:"s)) { m.segment = seg_gs; line.set_begin(line.begin() + 3); }
+
+			assert(line.front() == '[');
+			line.set_begin(line.begin() + 1);
 
 			bool has_regs = false;
 
-			if (auto reg = parse_gpr(); !reg.is<Empty>()) {
+			auto parse_scale = [&]() {
+				line.set_begin(line.begin() + 1);
+				if (false) {}
+				else if (line.front() == '1') { m.index_scale = 1; }
+				else if (line.front() == '2') { m.index_scale = 2; }
+				else if (line.front() == '4') { m.index_scale = 4; }
+				else if (line.front() == '8') { m.index_scale = 8; }
+				line.set_begin(line.begin() + 1);
+			};
+
+			if (auto index = parse_vector_index()) {
+				has_regs = true;
+				vector_index = index;
+				parse_scale();
+			} else if (auto reg = parse_gpr(); !reg.is<Empty>()) {
 				has_regs = true;
 
 				if (reg.is<Gpr32>()) {
@@ -385,6 +447,9 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 					} else {
 						m.index_scale = 1;
 					}
+				} else if (auto index = parse_vector_index()) {
+					vector_index = index;
+					parse_scale();
 				} else {
 					line.set_begin(line.begin() - 1);
 				}
@@ -405,7 +470,18 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 			assert(line.front() == ']');
 			line.set_begin(line.begin() + 1);
 
-			result.operands.add(m);
+			if (vector_index) {
+				Vsib v = {};
+				v.base = m.base;
+				v.index = vector_index.value();
+				v.base_scale = m.base_scale;
+				v.index_scale = m.index_scale;
+				v.size_override = m.size_override;
+				v.displacement = m.displacement;
+				result.operands.add(v);
+			} else {
+				result.operands.add(m);
+			}
 		} else {
 			auto number_begin = line.begin();
 			while (1) {
@@ -450,7 +526,7 @@ Optional<InstrDesc> parse_dumpbin_disasm_line(String line) {
 	}
 
 	// why the hell dumBbin prints two operands for those when it should take only one?...
-	if (result.mnemonic == "div" || result.mnemonic == "mul") {
+	if (result.mnemonic == "div" || result.mnemonic == "mul" || result.mnemonic == "idiv") {
 		result.operands.erase_at(0);
 	}
 
@@ -483,6 +559,7 @@ s32 tl_main(Span<String> args) {
 	Array xmms {xmm0,xmm1,xmm2,xmm3,xmm4,xmm5,xmm6,xmm7,xmm8,xmm9,xmm10,xmm11,xmm12,xmm13,xmm14,xmm15};
 	Array ymms {ymm0,ymm1,ymm2,ymm3,ymm4,ymm5,ymm6,ymm7,ymm8,ymm9,ymm10,ymm11,ymm12,ymm13,ymm14,ymm15};
 	Array zmms {zmm0,zmm1,zmm2,zmm3,zmm4,zmm5,zmm6,zmm7,zmm8,zmm9,zmm10,zmm11,zmm12,zmm13,zmm14,zmm15};
+	Array kregs {k0,k1,k2,k3,k4,k5,k6,k7};
 	#else
 	Array regs8  {al,ah,r8b,spl,bpl};
 	Array regs16 {ax,sp,bp,r8w};
@@ -491,6 +568,7 @@ s32 tl_main(Span<String> args) {
 	Array xmms {xmm0,xmm8};
 	Array ymms {ymm0,ymm8};
 	Array zmms {zmm0,zmm8};
+	Array kregs {k0,k7};
 	#endif
 			
 	List<Mem> mems;
@@ -586,6 +664,14 @@ s32 tl_main(Span<String> args) {
 					}
 					append(ml64_builder, op);
 				}
+				else if constexpr (std::is_same_v<decltype(op), Vsib>) {
+					switch (size) {
+						case 32: append(ml64_builder, "dword ptr "); break;
+						case 64: append(ml64_builder, "qword ptr "); break;
+					}
+					char const *index_names[] = {"xmm", "ymm", "zmm"};
+					append_vsib(ml64_builder, op, index_names[op.index_size]);
+				}
 				else append(ml64_builder, op);
 			};
 
@@ -871,6 +957,44 @@ s32 tl_main(Span<String> args) {
 		//with(ConsoleColor::green, println("Successfully encoded {} bytes of {} instructions", c - buf, instr_infos.count));
 	};
 
+	// For what can't go through ml64 and dumpbin: compares encoding of `instr` with known bytes.
+	auto check_bytes = Combine {
+		[&](Span<u8> expected, auto instr, auto ...args) {
+			u8 actual[X64W_MAX_INSTRUCTION_SIZE];
+			u8 *a = actual;
+			if (auto reason = instr(&a, args...)) {
+				with(ConsoleColor::red, println("Failed to encode {}\nReason: {}", format_hex(expected), reason));
+				exit(1);
+			}
+			if (expected != Span(actual, a)) {
+				with(ConsoleColor::red, println("Encoding mismatch.\nactual:   {}\nexpected: {}", format_hex(Span(actual, a)), format_hex(expected)));
+				exit(1);
+			}
+		},
+		[&](this auto &&self, std::initializer_list<u8> bytes, auto instr, auto ...args) {
+			u8 expected[X64W_MAX_INSTRUCTION_SIZE];
+			u8 *e = expected;
+			for (auto b : bytes)
+				*e++ = b;
+			self(Span(expected, e), instr, args...);
+		},
+	};
+	auto check_rejected = [&](auto instr, auto ...args) {
+		u8 actual[X64W_MAX_INSTRUCTION_SIZE];
+		u8 *a = actual;
+		if (!instr(&a, args...)) {
+			with(ConsoleColor::red, println("Encoding {} should have been rejected", format_hex(Span(actual, a))));
+			exit(1);
+		}
+	};
+
+	// Accumulator register is implied by the opcode, lambdas take it only for it to be printed and compared
+	#define TEST_ACC(name)                                                                                                         \
+		test(u8###name##s,  8, [](u8 **c, Gpr8,  s8  i) { return x64w_##name##_al_i8  (c, i); }, al,  (int8_t )0x123456789abcdef); \
+		test(u8###name##s, 16, [](u8 **c, Gpr16, s16 i) { return x64w_##name##_ax_i16 (c, i); }, ax,  (int16_t)0x123456789abcdef); \
+		test(u8###name##s, 32, [](u8 **c, Gpr32, s32 i) { return x64w_##name##_eax_i32(c, i); }, eax, (int32_t)0x123456789abcdef); \
+		test(u8###name##s, 32, [](u8 **c, Gpr64, s32 i) { return x64w_##name##_rax_i32(c, i); }, rax, (int32_t)0x123456789abcdef);
+
 	
 	#define TEST1(name)        \
 		do {                   \
@@ -886,6 +1010,7 @@ s32 tl_main(Span<String> args) {
 			TEST_M16I8(name); \
 			TEST_M32I8(name); \
 			TEST_M64I8(name); \
+			TEST_ACC(name);    \
 			run_dumpbin();     \
 		} while (0)
 
@@ -939,12 +1064,14 @@ s32 tl_main(Span<String> args) {
 	TEST1(xor);
 	TEST1(and);
 	TEST1(or);
+	TEST1(cmp);
 	TEST2(dec);
 	TEST2(inc);
 	TEST2(neg);
 	TEST2(not);
 	TEST2(div);
 	TEST2(mul);
+	TEST2(idiv);
 	TEST_SHIFT(shl);
 	TEST_SHIFT(shr);
 	TEST_SHIFT(sal);
@@ -958,6 +1085,497 @@ s32 tl_main(Span<String> args) {
 		run_dumpbin();    
 	} while (0);
 
+	do {
+		begin_test("imul");
+		TEST_RR16(imul);
+		TEST_RR32(imul);
+		TEST_RR64(imul);
+		TEST_RM16(imul);
+		TEST_RM32(imul);
+		TEST_RM64(imul);
+		for (auto a : regs16) for (auto b : regs16) test(u8"imul"s, 16, x64w_imul_rri16,   a, b, (int16_t)0x123456789abcdef);
+		for (auto a : regs32) for (auto b : regs32) test(u8"imul"s, 32, x64w_imul_rri32,   a, b, (int32_t)0x123456789abcdef);
+		for (auto a : regs64) for (auto b : regs64) test(u8"imul"s, 32, x64w_imul_rr64i32, a, b, (int32_t)0x123456789abcdef);
+		for (auto a : regs16) for (auto b : regs16) test(u8"imul"s,  8, x64w_imul_rr16i8,  a, b, (int8_t)0x123456789abcdef);
+		for (auto a : regs32) for (auto b : regs32) test(u8"imul"s,  8, x64w_imul_rr32i8,  a, b, (int8_t)0x123456789abcdef);
+		for (auto a : regs64) for (auto b : regs64) test(u8"imul"s,  8, x64w_imul_rr64i8,  a, b, (int8_t)0x123456789abcdef);
+		run_dumpbin();
+	} while (0);
+
+	// ah,ch,dh,bh can't be used with REX prefix
+	#define TEST_EXTEND(name)                                                                                                                \
+		do {                                                                                                                                 \
+			begin_test(#name);                                                                                                               \
+			for (auto a : regs16) for (auto b : regs8) if (a.i < 8 || b.i < 4 || b.i > 7) test(u8###name##s,  8, x64w_##name##_r16r8, a, b); \
+			for (auto a : regs32) for (auto b : regs8) if (a.i < 8 || b.i < 4 || b.i > 7) test(u8###name##s,  8, x64w_##name##_r32r8, a, b); \
+			for (auto a : regs64) for (auto b : regs8) if (b.i < 4 || b.i > 7)            test(u8###name##s,  8, x64w_##name##_r64r8, a, b); \
+			for (auto a : regs32) for (auto b : regs16) test(u8###name##s, 16, x64w_##name##_r32r16, a, b);                                  \
+			for (auto a : regs64) for (auto b : regs16) test(u8###name##s, 16, x64w_##name##_r64r16, a, b);                                  \
+			for (auto a : regs16) for (auto b : mems)   test(u8###name##s,  8, x64w_##name##_r16m8,  a, b);                                  \
+			for (auto a : regs32) for (auto b : mems)   test(u8###name##s,  8, x64w_##name##_r32m8,  a, b);                                  \
+			for (auto a : regs64) for (auto b : mems)   test(u8###name##s,  8, x64w_##name##_r64m8,  a, b);                                  \
+			for (auto a : regs32) for (auto b : mems)   test(u8###name##s, 16, x64w_##name##_r32m16, a, b);                                  \
+			for (auto a : regs64) for (auto b : mems)   test(u8###name##s, 16, x64w_##name##_r64m16, a, b);                                  \
+			run_dumpbin();                                                                                                                   \
+		} while (0)
+
+	TEST_EXTEND(movzx);
+	TEST_EXTEND(movsx);
+
+	do {
+		begin_test("movsxd");
+		for (auto a : regs64) for (auto b : regs32) test(u8"movsxd"s, 32, x64w_movsxd_r64r32, a, b);
+		for (auto a : regs64) for (auto b : mems)   test(u8"movsxd"s, 32, x64w_movsxd_r64m32, a, b);
+		run_dumpbin();
+	} while (0);
+
+	#define TEST_BITSCAN(name) \
+		do {                   \
+			begin_test(#name); \
+			TEST_RR16(name);   \
+			TEST_RR32(name);   \
+			TEST_RR64(name);   \
+			TEST_RM16(name);   \
+			TEST_RM32(name);   \
+			TEST_RM64(name);   \
+			run_dumpbin();     \
+		} while (0)
+
+	TEST_BITSCAN(bsf);
+	TEST_BITSCAN(bsr);
+	TEST_BITSCAN(popcnt);
+	TEST_BITSCAN(lzcnt);
+	TEST_BITSCAN(tzcnt);
+
+	#define TEST_VRRR(name, size) for (auto a : regs##size) for (auto b : regs##size) for (auto d : regs##size) test(u8###name##s, size, x64w_##name##_rrr##size, a, b, d);
+	#define TEST_VRRM(name, size) for (auto a : regs##size) for (auto b : regs##size) for (auto m : mems)        test(u8###name##s, size, x64w_##name##_rrm##size, a, b, m);
+	#define TEST_VRMR(name, size) for (auto a : regs##size) for (auto m : mems)        for (auto d : regs##size) test(u8###name##s, size, x64w_##name##_rmr##size, a, m, d);
+
+	do {
+		begin_test("adx");
+		TEST_RR32(adcx);
+		TEST_RR64(adcx);
+		TEST_RM32(adcx);
+		TEST_RM64(adcx);
+		TEST_RR32(adox);
+		TEST_RR64(adox);
+		TEST_RM32(adox);
+		TEST_RM64(adox);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("bmi");
+		TEST_VRRR(andn, 32);
+		TEST_VRRR(andn, 64);
+		TEST_VRRM(andn, 64);
+		TEST_VRRR(bextr, 64);
+		TEST_VRMR(bextr, 32);
+		TEST_RR32(blsr);
+		TEST_RR64(blsmsk);
+		TEST_RM64(blsi);
+		TEST_VRRR(bzhi, 64);
+		TEST_VRRR(shlx, 32);
+		TEST_VRRR(sarx, 64);
+		TEST_VRMR(shrx, 64);
+		for (auto a : regs64) for (auto b : regs64) test(u8"rorx"s, 8, x64w_rorx_rri64, a, b, (int8_t)0x123456789abcdef);
+		TEST_VRRR(pdep, 64);
+		TEST_VRRM(pext, 32);
+		TEST_VRRR(mulx, 64);
+		run_dumpbin();
+	} while (0);
+
+	#define TEST_XX(name)       for (auto a : xmms) for (auto b : xmms) test(u8###name##s,  128, x64w_##name##_xx, a, b);
+	#define TEST_XM(name, size) for (auto a : xmms) for (auto b : mems) test(u8###name##s, size, x64w_##name##_xm, a, b);
+	#define TEST_MX(name, size) for (auto a : mems) for (auto b : xmms) test(u8###name##s, size, x64w_##name##_mx, a, b);
+
+	#define TEST_SCALAR(name, size) \
+		TEST_XX(name);              \
+		TEST_XM(name, size);
+
+	do {
+		begin_test("sse scalar");
+		TEST_SCALAR(addss, 32);
+		TEST_SCALAR(addsd, 64);
+		TEST_SCALAR(subsd, 64);
+		TEST_SCALAR(mulsd, 64);
+		TEST_SCALAR(divsd, 64);
+		TEST_SCALAR(sqrtsd, 64);
+		TEST_SCALAR(cvtsd2ss, 64);
+		TEST_SCALAR(ucomisd, 64);
+		TEST_SCALAR(comisd, 64);
+		TEST_SCALAR(movss, 32);
+		TEST_SCALAR(movsd, 64);
+		TEST_MX(movss, 32);
+		TEST_MX(movsd, 64);
+		for (auto a : xmms)   for (auto b : regs32) test(u8"cvtsi2sd"s,  32, x64w_cvtsi2sd_xr32,  a, b);
+		for (auto a : xmms)   for (auto b : regs64) test(u8"cvtsi2sd"s,  64, x64w_cvtsi2sd_xr64,  a, b);
+		for (auto a : xmms)   for (auto b : mems)   test(u8"cvtsi2sd"s,  32, x64w_cvtsi2sd_xm32,  a, b);
+		for (auto a : xmms)   for (auto b : mems)   test(u8"cvtsi2sd"s,  64, x64w_cvtsi2sd_xm64,  a, b);
+		for (auto a : regs32) for (auto b : xmms)   test(u8"cvttsd2si"s, 32, x64w_cvttsd2si_r32x, a, b);
+		for (auto a : regs64) for (auto b : xmms)   test(u8"cvttsd2si"s, 64, x64w_cvttsd2si_r64x, a, b);
+		for (auto a : regs32) for (auto b : mems)   test(u8"cvttsd2si"s, 64, x64w_cvttsd2si_r32m, a, b);
+		for (auto a : regs64) for (auto b : mems)   test(u8"cvttsd2si"s, 64, x64w_cvttsd2si_r64m, a, b);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("movd/movq");
+		for (auto a : xmms)   for (auto b : regs32) test(u8"movd"s, 32, x64w_movd_xr32, a, b);
+		for (auto a : regs32) for (auto b : xmms)   test(u8"movd"s, 32, x64w_movd_r32x, a, b);
+		for (auto a : xmms)   for (auto b : regs64) test(u8"movq"s, 64, x64w_movq_xr64, a, b);
+		for (auto a : regs64) for (auto b : xmms)   test(u8"movq"s, 64, x64w_movq_r64x, a, b);
+		TEST_XM(movd, 32);
+		TEST_MX(movd, 32);
+		TEST_XX(movq);
+		TEST_XM(movq, 64);
+		TEST_MX(movq, 64);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("sse4.2");
+		for (auto a : regs32) for (auto b : regs8) if (a.i < 8 || b.i < 4 || b.i > 7) test(u8"crc32"s,  8, x64w_crc32_r32r8,  a, b);
+		for (auto a : regs64) for (auto b : regs8) if (b.i < 4 || b.i > 7)            test(u8"crc32"s,  8, x64w_crc32_r64r8,  a, b);
+		for (auto a : regs32) for (auto b : regs16) test(u8"crc32"s, 16, x64w_crc32_r32r16, a, b);
+		for (auto a : regs32) for (auto b : regs32) test(u8"crc32"s, 32, x64w_crc32_r32r32, a, b);
+		for (auto a : regs64) for (auto b : regs64) test(u8"crc32"s, 64, x64w_crc32_r64r64, a, b);
+		for (auto a : regs32) for (auto b : mems)   test(u8"crc32"s,  8, x64w_crc32_r32m8,  a, b);
+		for (auto a : regs32) for (auto b : mems)   test(u8"crc32"s, 16, x64w_crc32_r32m16, a, b);
+		for (auto a : regs32) for (auto b : mems)   test(u8"crc32"s, 32, x64w_crc32_r32m32, a, b);
+		for (auto a : regs64) for (auto b : mems)   test(u8"crc32"s,  8, x64w_crc32_r64m8,  a, b);
+		for (auto a : regs64) for (auto b : mems)   test(u8"crc32"s, 64, x64w_crc32_r64m64, a, b);
+		for (auto a : xmms) for (auto b : xmms) test(u8"pcmpistri"s, 8, x64w_pcmpistri_xxi, a, b, (int8_t)0x123456789abcdef);
+		for (auto a : xmms) for (auto b : mems) test(u8"pcmpistri"s, 8, x64w_pcmpistri_xmi, a, b, (int8_t)0x123456789abcdef);
+		for (auto a : xmms) for (auto b : xmms) test(u8"pcmpestrm"s, 8, x64w_pcmpestrm_xxi, a, b, (int8_t)0x123456789abcdef);
+		for (auto a : xmms) for (auto b : mems) test(u8"pcmpestrm"s, 8, x64w_pcmpestrm_xmi, a, b, (int8_t)0x123456789abcdef);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("cache control");
+		TEST_MR32(movnti);
+		TEST_MR64(movnti);
+		TEST_M8(prefetcht0);
+		TEST_M8(prefetcht1);
+		TEST_M8(prefetcht2);
+		TEST_M8(prefetchnta);
+		TEST_M8(prefetchw);
+		TEST_M8(clflushopt);
+		TEST_M8(clwb);
+		test(u8"sfence"s, 0, x64w_sfence);
+		TEST_MX(movntdq, 128);
+		for (auto m : mems) for (auto a : xmms) test(u8"vmovntdq"s, 128, x64w_vmovntdq_mx, m, a);
+		for (auto m : mems) for (auto a : ymms) test(u8"vmovntdq"s, 256, x64w_vmovntdq_my, m, a);
+		for (auto m : mems) for (auto a : zmms) test(u8"vmovntdq"s, 512, x64w_vmovntdq_mz, m, a);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("atomic");
+		TEST_RR8(xchg);
+		TEST_RR64(xchg);
+		TEST_MR8(xchg);
+		TEST_MR16(xchg);
+		TEST_MR32(xchg);
+		TEST_MR64(xchg);
+		TEST_MR8(cmpxchg);
+		TEST_MR64(cmpxchg);
+		TEST_MR8(xadd);
+		TEST_MR32(xadd);
+		TEST_M64(cmpxchg8b);
+		test(u8"mfence"s, 0, x64w_mfence);
+		test(u8"lfence"s, 0, x64w_lfence);
+		test(u8"pause"s, 0, x64w_pause);
+		run_dumpbin();
+	} while (0);
+
+	// String operations, operand size prefix goes before rep and REX after it
+	do {
+		print("string ");
+		check_bytes({0xa4},             movsb);
+		check_bytes({0x66, 0xa5},       movsw);
+		check_bytes({0xa5},             movsd);
+		check_bytes({0x48, 0xa5},       movsq);
+		check_bytes({0xf3, 0xa4},       rep_movsb);
+		check_bytes({0x66, 0xf3, 0xa5}, rep_movsw);
+		check_bytes({0xf3, 0xa5},       rep_movsd);
+		check_bytes({0xf3, 0x48, 0xa5}, rep_movsq);
+		check_bytes({0xf3, 0xaa},       rep_stosb);
+		check_bytes({0x66, 0xf3, 0xab}, rep_stosw);
+		check_bytes({0xf3, 0xab},       rep_stosd);
+		check_bytes({0xf3, 0x48, 0xab}, rep_stosq);
+		check_bytes({0x66, 0xab},       stosw);
+		check_bytes({0xac},             lodsb);
+		check_bytes({0x48, 0xad},       lodsq);
+		check_bytes({0xaf},             scasd);
+		check_bytes({0x66, 0xa7},       cmpsw);
+		check_bytes({0xf3, 0xa6},       repe_cmpsb);
+		check_bytes({0xf3, 0x48, 0xa7}, repe_cmpsq);
+		check_bytes({0xf2, 0xa7},       repne_cmpsd);
+		check_bytes({0x66, 0xf3, 0xaf}, repe_scasw);
+		check_bytes({0xf2, 0xae},       repne_scasb);
+		check_bytes({0xf2, 0x48, 0xaf}, repne_scasq);
+	} while (0);
+
+	// Lock prefix goes first, before segment, address size, operand size and REX prefixes
+	do {
+		print("lock ");
+		check_bytes({0xf0, 0x80, 0x00, 0x01},                               lock_add_mi8,         mem64_b(rax), (s8)1);
+		check_bytes({0xf0, 0x65, 0x67, 0x4c, 0x01, 0x49, 0x10},             lock_add_mr64,        mem_gs(mem32_bd(ecx, 0x10)), r9);
+		check_bytes({0xf0, 0x64, 0x67, 0x66, 0x41, 0x81, 0x28, 0x34, 0x12}, lock_sub_mi16,        mem_fs(mem32_b(r8d)), (s16)0x1234);
+		check_bytes({0xf0, 0x4b, 0x83, 0x0c, 0xec, 0xff},                   lock_or_m64i8,        mem64_bi(r12, r13, 8), (s8)-1);
+		check_bytes({0xf0, 0x64, 0x66, 0x41, 0xff, 0x02},                   lock_inc_m16,         mem_fs(mem64_b(r10)));
+		check_bytes({0xf0, 0xf6, 0x16},                                     lock_not_m8,          mem64_b(rsi));
+		check_bytes({0xf0, 0x40, 0x0f, 0xb0, 0x37},                         lock_cmpxchg_mr8,     mem64_b(rdi), sil);
+		check_bytes({0xf0, 0x65, 0x67, 0x66, 0x44, 0x0f, 0xb1, 0x18},       lock_cmpxchg_mr16,    mem_gs(mem32_b(eax)), r11w);
+		check_bytes({0xf0, 0x48, 0x0f, 0xb1, 0x55, 0x08},                   lock_cmpxchg_mr64,    mem64_bd(rbp, 8), rdx);
+		check_bytes({0xf0, 0x41, 0x0f, 0xc1, 0x07},                         lock_xadd_mr32,       mem64_b(r15), eax);
+		check_bytes({0xf0, 0x64, 0x66, 0x0f, 0xc1, 0x0b},                   lock_xadd_mr16,       mem_fs(mem64_b(rbx)), cx);
+		check_bytes({0xf0, 0x0f, 0xc7, 0x0e},                               lock_cmpxchg8b_m64,   mem64_b(rsi));
+		check_bytes({0xf0, 0x65, 0x67, 0x49, 0x0f, 0xc7, 0x09},             lock_cmpxchg16b_m128, mem_gs(mem32_b(r9d)));
+	} while (0);
+
+	do {
+		begin_test("timing");
+		test(u8"rdtsc"s,  0, x64w_rdtsc);
+		test(u8"rdtscp"s, 0, x64w_rdtscp);
+		test(u8"rdpmc"s,  0, x64w_rdpmc);
+		test(u8"cpuid"s,  0, x64w_cpuid);
+		run_dumpbin();
+	} while (0);
+
+	#define TEST_VEC(name)                                                                                         \
+		for (auto a : xmms) for (auto b : xmms) for (auto d : xmms) test(u8###name##s, 128, x64w_##name##_xxx, a, b, d); \
+		for (auto a : xmms) for (auto b : xmms) for (auto m : mems) test(u8###name##s, 128, x64w_##name##_xxm, a, b, m); \
+		for (auto a : ymms) for (auto b : ymms) for (auto d : ymms) test(u8###name##s, 256, x64w_##name##_yyy, a, b, d); \
+		for (auto a : ymms) for (auto b : ymms) for (auto m : mems) test(u8###name##s, 256, x64w_##name##_yym, a, b, m); \
+		for (auto a : zmms) for (auto b : zmms) for (auto d : zmms) test(u8###name##s, 512, x64w_##name##_zzz, a, b, d); \
+		for (auto a : zmms) for (auto b : zmms) for (auto m : mems) test(u8###name##s, 512, x64w_##name##_zzm, a, b, m);
+
+	do {
+		begin_test("avx");
+		TEST_VEC(vaddps);
+		TEST_VEC(vaddpd);
+		TEST_VEC(vmulpd);
+		TEST_VEC(vpaddd);
+		TEST_VEC(vpaddq);
+		TEST_VEC(vpmulld);
+		for (auto a : ymms) for (auto b : ymms) test(u8"vpermq"s, 8, x64w_vpermq_yyi, a, b, (int8_t)0x123456789abcdef);
+		for (auto a : zmms) for (auto m : mems) test(u8"vpermq"s, 8, x64w_vpermq_zmi, a, m, (int8_t)0x123456789abcdef);
+		run_dumpbin();
+	} while (0);
+
+	#define TEST_FMA_SCALAR(name, size)                                                                           \
+		for (auto a : xmms) for (auto b : xmms) for (auto d : xmms) test(u8###name##s,  128, x64w_##name##_xxx, a, b, d); \
+		for (auto a : xmms) for (auto b : xmms) for (auto m : mems) test(u8###name##s, size, x64w_##name##_xxm, a, b, m);
+
+	do {
+		begin_test("fma");
+		TEST_VEC(vfmadd132ps);
+		TEST_VEC(vfmadd213pd);
+		TEST_VEC(vfnmsub231pd);
+		TEST_FMA_SCALAR(vfmadd231ss, 32);
+		TEST_FMA_SCALAR(vfmsub132sd, 64);
+		TEST_FMA_SCALAR(vfnmadd213sd, 64);
+		run_dumpbin();
+	} while (0);
+
+	// EVEX scales 8-bit displacement by the size of memory operand
+	do {
+		begin_test("disp8*N");
+		for (auto a : zmms) for (auto b : regs64) for (s32 i : {-129, -128, -1, 1, 127, 128}) {
+			test(u8"vaddpd"s, 512, x64w_vaddpd_zzm, a, a, mem64_bd(b, i * 64));
+			test(u8"vaddpd"s, 512, x64w_vaddpd_zzm, a, a, mem64_bd(b, i * 64 + 8));
+		}
+		run_dumpbin();
+	} while (0);
+
+	// EVEX opmask (aaa), zeroing (z) and broadcast (b) bits, with registers above 15
+	do {
+		print("evex masking ");
+		check_bytes({0x62, 0xf1, 0xed, 0x49, 0x58, 0xcb},             vaddpd_zkzz,        zmm1, k1, zmm2, zmm3);
+		check_bytes({0x62, 0xc1, 0x0c, 0xc7, 0x58, 0xc9},             vaddps_zkzz_z,      zmm17, k7, zmm30, zmm9);
+		check_bytes({0x62, 0xf1, 0xd5, 0x4a, 0x58, 0x60, 0x01},       vaddpd_zkzm,        zmm4, k2, zmm5, mem64_bd(rax, 0x40));
+		check_bytes({0x62, 0xc1, 0x74, 0xcb, 0x5c, 0x64, 0x48, 0xfe}, vsubps_zkzm_z,      zmm20, k3, zmm1, mem64_bid(r8, rcx, 2, -0x80));
+		check_bytes({0x62, 0xf1, 0xf5, 0x58, 0x59, 0x42, 0x01},       vmulpd_zzb,         zmm0, zmm1, mem64_bd(rdx, 8));
+		check_bytes({0x62, 0x61, 0x7c, 0x50, 0x59, 0x7a, 0x10},       vmulps_zzb,         zmm31, zmm16, mem64_bd(rdx, 0x40));
+		check_bytes({0x62, 0xf1, 0x65, 0x5c, 0xfe, 0x14, 0x24},       vpaddd_zkzb,        zmm2, k4, zmm3, mem64_b(rsp));
+		check_bytes({0x62, 0xf1, 0xb5, 0xd5, 0xd4, 0x75, 0xff},       vpaddq_zkzb_z,      zmm6, k5, zmm25, mem64_bd(rbp, -8));
+		check_bytes({0x62, 0x12, 0xfd, 0xc6, 0xb8, 0xc0},             vfmadd231pd_zkzz_z, zmm8, k6, zmm16, zmm24);
+	} while (0);
+
+	// Gathers require all registers to differ, index is not in xmms/ymms unless ALL_PERMUTATIONS is set.
+	// Index is as wide as the data register in the tested forms.
+	List<Vsib> xmm_vsibs;
+	List<Vsib> ymm_vsibs;
+	auto add_vsibs = [&](List<Vsib> &vsibs, auto x1, auto x9) {
+		for (auto b : regs64) for (auto x : {x1, x9}) for (u8 is : {1, 8}) {
+			vsibs.add(vsib64_bi(b, x, is));
+			vsibs.add(vsib64_bid(b, x, is, 0x34));
+			vsibs.add(vsib64_bid(b, x, is, 0x3456));
+		}
+		for (auto x : {x1, x9}) vsibs.add(vsib64_id(x, 4, 0x34));
+		for (auto x : {x1, x9}) vsibs.add(vsib32_bi(eax, x, 2));
+	};
+	add_vsibs(xmm_vsibs, xmm1, xmm9);
+	add_vsibs(ymm_vsibs, ymm1, ymm9);
+
+	#define TEST_GATHER(name, size)                                                                                    \
+		for (auto a : xmms) for (auto m : xmm_vsibs) for (auto v : xmms) if (a != v && m.index != a.i && m.index != v.i) test(u8###name##s, size, x64w_##name##_xvx, a, m, v); \
+		for (auto a : ymms) for (auto m : ymm_vsibs) for (auto v : ymms) if (a != v && m.index != a.i && m.index != v.i) test(u8###name##s, size, x64w_##name##_yvy, a, m, v);
+
+	do {
+		begin_test("gather");
+		TEST_GATHER(vpgatherdd, 32);
+		TEST_GATHER(vpgatherqq, 64);
+		TEST_GATHER(vgatherdps, 32);
+		run_dumpbin();
+	} while (0);
+
+	// EVEX gathers and scatters, with index in zmm16-31 (EVEX.V') and disp8*N scaled by element size
+	do {
+		print("evex gather ");
+		check_bytes({0x62, 0xf2, 0x7d, 0x49, 0x90, 0x4c, 0x90, 0x10},                   vpgatherdd_zkv,  zmm1, k1, vsib64_bid(rax, zmm2, 4, 0x40));
+		check_bytes({0x62, 0xf2, 0xfd, 0x42, 0x91, 0x4c, 0xe0, 0x08},                   vpgatherqq_zkv,  zmm1, k2, vsib64_bid(rax, zmm20, 8, 0x40));
+		check_bytes({0x62, 0xc2, 0xfd, 0x4b, 0x92, 0x4c, 0xd9, 0x10},                   vgatherdpd_zkv,  zmm17, k3, vsib64_bid(r9, ymm3, 8, 0x80));
+		check_bytes({0x62, 0xf2, 0x7d, 0x01, 0x92, 0x1c, 0x04},                         vgatherdps_xkv,  xmm3, k1, vsib64_bi(rsp, xmm16, 1));
+		check_bytes({0x62, 0xf2, 0x7d, 0x41, 0xa0, 0x6c, 0x93, 0xc0},                   vpscatterdd_vkz, vsib64_bid(rbx, zmm18, 4, -0x100), k1, zmm5);
+		check_bytes({0x62, 0x12, 0xfd, 0x44, 0xa2, 0x8c, 0x4d, 0x44, 0x00, 0x00, 0x00}, vscatterdpd_vkz, vsib64_bid(r13, ymm25, 2, 0x44), k4, zmm9);
+		check_bytes({0x62, 0x22, 0xfd, 0x27, 0xa1, 0x74, 0x3d, 0x01},                   vpscatterqq_vky, vsib64_bid(rbp, ymm31, 1, 8), k7, ymm30);
+
+		// Index of other size than the form's
+		check_rejected(vpgatherdd_yvy,  ymm1, vsib64_bi(rax, xmm2, 4), ymm3);
+		check_rejected(vgatherdpd_ykv,  ymm1, k1, vsib64_bi(rax, zmm2, 8));
+		check_rejected(vgatherdpd_zkv,  zmm1, k1, vsib64_bi(rax, zmm2, 8));
+		check_rejected(vpscatterqq_vkz, vsib64_bi(rax, ymm2, 8), k1, zmm1);
+	} while (0);
+
+	do {
+		begin_test("crypto");
+		TEST_XX(aesenc);
+		TEST_XM(aesenc, 128);
+		TEST_XX(aesdeclast);
+		TEST_XM(aesdeclast, 128);
+		TEST_XX(aesimc);
+		TEST_XX(sha1msg1);
+		TEST_XM(sha256msg2, 128);
+		for (auto a : xmms) for (auto b : xmms) test(u8"aeskeygenassist"s, 8, x64w_aeskeygenassist_xxi, a, b, (int8_t)0x123456789abcdef);
+		for (auto a : xmms) for (auto m : mems) test(u8"sha1rnds4"s,       8, x64w_sha1rnds4_xmi,       a, m, (int8_t)0x123456789abcdef);
+		TEST_VEC(vaesenc);
+		TEST_VEC(vaesdeclast);
+		TEST_XX(vaesimc);
+		for (auto a : xmms) for (auto m : mems) test(u8"vaeskeygenassist"s, 8, x64w_vaeskeygenassist_xmi, a, m, (int8_t)0x123456789abcdef);
+		run_dumpbin();
+
+		// Key schedule helpers have only the VEX form, which can't encode xmm16-31
+		check_rejected(vaesimc_xx,           xmm17, xmm1);
+		check_rejected(vaeskeygenassist_xxi, xmm1, xmm20, (u8)0x12);
+	} while (0);
+
+	#define TEST_KKK(name) for (auto a : kregs) for (auto b : kregs) for (auto d : kregs) test(u8###name##s, 16, x64w_##name##_kkk, a, b, d);
+	#define TEST_KK(name)  for (auto a : kregs) for (auto b : kregs)                      test(u8###name##s, 16, x64w_##name##_kk,  a, b);
+
+	do {
+		begin_test("opmask");
+		TEST_KKK(kandb);
+		TEST_KKK(kandw);
+		TEST_KKK(kandd);
+		TEST_KKK(kandq);
+		TEST_KKK(korw);
+		TEST_KKK(kxorq);
+		TEST_KK(knotw);
+		TEST_KK(kortestw);
+		TEST_KK(kortestq);
+		TEST_KK(kmovw);
+		TEST_KK(kmovq);
+		for (auto a : kregs)  for (auto m : mems)   test(u8"kmovw"s, 16, x64w_kmovw_km, a, m);
+		for (auto m : mems)   for (auto a : kregs)  test(u8"kmovd"s, 32, x64w_kmovd_mk, m, a);
+		for (auto a : kregs)  for (auto b : regs32) test(u8"kmovd"s, 32, x64w_kmovd_kr, a, b);
+		for (auto a : regs64) for (auto b : kregs)  test(u8"kmovq"s, 64, x64w_kmovq_rk, a, b);
+		run_dumpbin();
+	} while (0);
+
+	List<Mem> segment_mems;
+	for (auto m : {mem64_d(0x28), mem64_bd(rax, 0x34), mem64_bid(r12, rcx, 4, 0x3456), mem32_bd(eax, 0x34)}) {
+		segment_mems.add(mem_fs(m));
+		segment_mems.add(mem_gs(m));
+	}
+
+	do {
+		begin_test("segment");
+		for (auto a : regs64) for (auto m : segment_mems) test(u8"mov"s,   64, x64w_mov_rm64, a, m);
+		for (auto m : segment_mems) for (auto a : regs32) test(u8"mov"s,   32, x64w_mov_mr32, m, a);
+		for (auto m : segment_mems)                       test(u8"add"s,   32, x64w_add_mi32, m, (int32_t)0x123456789abcdef);
+		for (auto m : segment_mems)                       test(u8"inc"s,   64, x64w_inc_m64,  m);
+		for (auto a : xmms) for (auto m : segment_mems)   test(u8"movss"s, 32, x64w_movss_xm, a, m);
+		for (auto a : ymms) for (auto b : ymms) for (auto m : segment_mems) test(u8"vaddps"s, 256, x64w_vaddps_yym, a, b, m);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("cwd");
+		test(u8"cbw"s,  16, x64w_cbw);
+		test(u8"cwde"s, 32, x64w_cwde);
+		test(u8"cdqe"s, 64, x64w_cdqe);
+		test(u8"cwd"s,  16, x64w_cwd);
+		test(u8"cdq"s,  32, x64w_cdq);
+		test(u8"cqo"s,  64, x64w_cqo);
+		run_dumpbin();
+	} while (0);
+
+	do {
+		begin_test("test");
+		TEST_RI(test);
+		TEST_RR(test);
+		TEST_MI(test);
+		TEST_MR(test);
+		TEST_ACC(test);
+		run_dumpbin();
+
+		// dumpbin shows the same text for the long forms, so check that the short ones were picked
+		check_bytes({0x04, 0x12},                         add_al_i8,    (s8)0x12);
+		check_bytes({0x66, 0x15, 0x34, 0x12},             adc_ax_i16,   (s16)0x1234);
+		check_bytes({0x3d, 0x78, 0x56, 0x34, 0x12},       cmp_eax_i32,  0x12345678);
+		check_bytes({0x48, 0x2d, 0xfe, 0xff, 0xff, 0xff}, sub_rax_i32,  -2);
+		check_bytes({0xa8, 0x12},                         test_al_i8,   (s8)0x12);
+		check_bytes({0x66, 0xa9, 0x34, 0x12},             test_ax_i16,  (s16)0x1234);
+		check_bytes({0xa9, 0x78, 0x56, 0x34, 0x12},       test_eax_i32, 0x12345678);
+		check_bytes({0x48, 0xa9, 0xfe, 0xff, 0xff, 0xff}, test_rax_i32, -2);
+	} while (0);
+
+	// Condition is a part of the mnemonic in disassembly
+	#define TEST_CC(cc)                                                                                                                                             \
+		do {                                                                                                                                                        \
+			begin_test("cc" #cc);                                                                                                                                   \
+			for (auto r : regs8)  test(u8"set" #cc ""s,    8, [](u8 **c, Gpr8 r) { return setcc_r8(c, cond_##cc, r); }, r);                                         \
+			for (auto m : mems)   test(u8"set" #cc ""s,    8, [](u8 **c, Mem m) { return setcc_m8(c, cond_##cc, m); }, m);                                          \
+			for (auto a : regs16) for (auto b : regs16) test(u8"cmov" #cc ""s, 16, [](u8 **c, Gpr16 a, Gpr16 b) { return cmovcc_rr16(c, cond_##cc, a, b); }, a, b); \
+			for (auto a : regs32) for (auto b : regs32) test(u8"cmov" #cc ""s, 32, [](u8 **c, Gpr32 a, Gpr32 b) { return cmovcc_rr32(c, cond_##cc, a, b); }, a, b); \
+			for (auto a : regs64) for (auto b : regs64) test(u8"cmov" #cc ""s, 64, [](u8 **c, Gpr64 a, Gpr64 b) { return cmovcc_rr64(c, cond_##cc, a, b); }, a, b); \
+			for (auto a : regs16) for (auto b : mems)   test(u8"cmov" #cc ""s, 16, [](u8 **c, Gpr16 a, Mem b) { return cmovcc_rm16(c, cond_##cc, a, b); }, a, b);   \
+			for (auto a : regs32) for (auto b : mems)   test(u8"cmov" #cc ""s, 32, [](u8 **c, Gpr32 a, Mem b) { return cmovcc_rm32(c, cond_##cc, a, b); }, a, b);   \
+			for (auto a : regs64) for (auto b : mems)   test(u8"cmov" #cc ""s, 64, [](u8 **c, Gpr64 a, Mem b) { return cmovcc_rm64(c, cond_##cc, a, b); }, a, b);   \
+			run_dumpbin();                                                                                                                                          \
+		} while (0)
+
+	TEST_CC(o);
+	TEST_CC(no);
+	TEST_CC(b);
+	TEST_CC(ae);
+	TEST_CC(e);
+	TEST_CC(ne);
+	TEST_CC(be);
+	TEST_CC(a);
+	TEST_CC(s);
+	TEST_CC(ns);
+	TEST_CC(p);
+	TEST_CC(np);
+	TEST_CC(l);
+	TEST_CC(ge);
+	TEST_CC(le);
+	TEST_CC(g);
+
 	//TEST_RI8(mov)
 	//TEST_RI16(mov)
 	//TEST_RI32(mov)
@@ -982,5 +1600,122 @@ s32 tl_main(Span<String> args) {
 	//test(u8"vaddpd"s, 128, vaddpd_xxx, xmm0, xmm8, xmm8);
 	//test(u8"vaddpd"s, 128, vaddpd_xxx, xmm8, xmm8, xmm8);
 
+	// x64w_encode has to produce the same bytes as direct calls
+	do {
+		print("encode ");
+
+		auto check = [&](x64w_Form form, Span<x64w_Operand> operands, auto instr, auto ...args) {
+			u8 expected[X64W_MAX_INSTRUCTION_SIZE];
+			u8 *e = expected;
+			instr(&e, args...);
+			check_bytes(Span(expected, e), encode, form, operands.data);
+		};
+
+		for (auto a : regs64) for (auto b : mems) {
+			x64w_Operand ops[] = {operand_r(a), operand_m(b)};
+			check(x64w_form_mov_rm64, array_as_span(ops), x64w_mov_rm64, a, b);
+		}
+		for (auto a : mems) {
+			x64w_Operand ops[] = {operand_m(a), operand_i((s8)0x12)};
+			check(x64w_form_add_m64i8, array_as_span(ops), x64w_add_m64i8, a, (s8)0x12);
+		}
+		for (auto a : regs8) {
+			x64w_Operand ops[] = {operand_r(a)};
+			check(x64w_form_neg_r8, array_as_span(ops), x64w_neg_r8, a);
+		}
+		for (auto a : ymms) for (auto b : ymms) for (auto d : ymms) {
+			x64w_Operand ops[] = {operand_r(a), operand_r(b), operand_r(d)};
+			check(x64w_form_vaddpd_yyy, array_as_span(ops), x64w_vaddpd_yyy, a, b, d);
+		}
+	} while (0);
+
+	// Nops have the requested length, padding ends on the boundary
+	do {
+		print("nop ");
+
+		alignas(64) u8 code[256];
+		for (unsigned n = 0; n <= X64W_MAX_INSTRUCTION_SIZE; ++n) {
+			u8 *a = code;
+			if (auto reason = nop(&a, n); reason || a != code + n) {
+				with(ConsoleColor::red, println("nop of {} bytes failed\nReason: {}", n, reason ? reason : "wrong length"));
+				exit(1);
+			}
+		}
+		for (unsigned boundary : {1, 16, 32, 64}) for (unsigned offset = 0; offset < 64; ++offset) {
+			u8 *a = code + offset;
+			if (auto reason = align(&a, boundary); reason || (umm)a % boundary || (unsigned)(a - (code + offset)) >= boundary) {
+				with(ConsoleColor::red, println("align to {} from offset {} failed\nReason: {}", boundary, offset, reason ? reason : "wrong padding"));
+				exit(1);
+			}
+		}
+	} while (0);
+
+	// Metadata of a few forms, with registers and flags they touch implicitly
+	do {
+		print("form info ");
+
+		auto check_info = [&](x64w_Form form, u16 implicit_read, u16 implicit_write, u16 flags_read, u16 flags_written, u16 flags_undefined) {
+			auto i = form_info(form);
+			if (i->implicit_read != implicit_read || i->implicit_write != implicit_write ||
+			    i->flags_read != flags_read || i->flags_written != flags_written || i->flags_undefined != flags_undefined) {
+				with(ConsoleColor::red, println("Form {} ({}) has wrong effects", (int)form, i->mnemonic));
+				exit(1);
+			}
+		};
+
+		auto check_vectors = [&](x64w_Form form, u16 implicit_vector_read, u16 implicit_vector_write) {
+			auto i = form_info(form);
+			if (i->implicit_vector_read != implicit_vector_read || i->implicit_vector_write != implicit_vector_write) {
+				with(ConsoleColor::red, println("Form {} ({}) has wrong implicit vector registers", (int)form, i->mnemonic));
+				exit(1);
+			}
+		};
+
+		u16 const status = x64w_flag_cf | x64w_flag_pf | x64w_flag_af | x64w_flag_zf | x64w_flag_sf | x64w_flag_of;
+		check_info(x64w_form_mul_r64,    x64w_mask_rax, x64w_mask_rax | x64w_mask_rdx, 0,            x64w_flag_cf | x64w_flag_of,             status & ~(x64w_flag_cf | x64w_flag_of));
+		check_info(x64w_form_mul_r8,     x64w_mask_rax, x64w_mask_rax,                 0,            x64w_flag_cf | x64w_flag_of,             status & ~(x64w_flag_cf | x64w_flag_of));
+		check_info(x64w_form_shl_r64_cl, x64w_mask_rcx, 0,                             status,       status & ~(x64w_flag_af | x64w_flag_of), x64w_flag_af | x64w_flag_of);
+		check_info(x64w_form_shl_m64i8,  0,             0,                             status,       status & ~(x64w_flag_af | x64w_flag_of), x64w_flag_af | x64w_flag_of);
+		check_info(x64w_form_shl_r64_1,  0,             0,                             0,            status & ~x64w_flag_af,                  x64w_flag_af);
+		check_info(x64w_form_adc_rr64,   0,             0,                             x64w_flag_cf, status,                                  0);
+		check_info(x64w_form_adc_mi8,    0,             0,                             x64w_flag_cf, status,                                  0);
+		check_info(x64w_form_inc_r32,    0,             0,                             0,            status & ~x64w_flag_cf,                  0);
+		check_info(x64w_form_inc_m8,     0,             0,                             0,            status & ~x64w_flag_cf,                  0);
+		check_vectors(x64w_form_pcmpestrm_xxi,  0,              x64w_mask_xmm0);
+		check_vectors(x64w_form_pcmpistrm_xmi,  0,              x64w_mask_xmm0);
+		check_vectors(x64w_form_pcmpestri_xxi,  0,              0);
+		check_vectors(x64w_form_sha256rnds2_xm, x64w_mask_xmm0, 0);
+		if (form_info((x64w_Form)x64w_form_count)) {
+			with(ConsoleColor::red, println("Invalid form should have no metadata"));
+			exit(1);
+		}
+	} while (0);
+
+	// ml64 can't assemble APX, these are compared with hand-assembled encodings
+	do {
+		print("apx ");
+
+		check_bytes({0xd5, 0x48, 0x8b, 0xc0},                         mov_rr64,  r16, rax);
+		check_bytes({0xd5, 0x19, 0x03, 0xc7},                         add_rr64,  rax, r31);
+		check_bytes({0xd5, 0x58, 0x8b, 0x0c, 0x24},                   mov_rm64,  r17, mem64_b(r20));
+		check_bytes({0xd5, 0xc8, 0xaf, 0xc1},                         imul_rr64, r16, rcx);
+		check_bytes({0x62, 0xf4, 0xf4, 0x18, 0x01, 0xda},             add_rrr64, rcx, rdx, rbx);
+		check_bytes({0x62, 0xf4, 0x0d, 0x10, 0x81, 0xd0, 0x34, 0x12}, adc_rri16, r30w, ax, (s16)0x1234);
+		check_bytes({0x62, 0xd4, 0x7c, 0x18, 0x2b, 0x08},             sub_rrm32, eax, ecx, mem64_b(r8));
+		check_bytes({0xd5, 0x18, 0x83, 0xc4, 0x05},                   add_r64i8, r20, (s8)5);
+		check_bytes({0xd5, 0x18, 0xc1, 0xe4, 0x03},                   shl_r64i8, r20, 3);
+		check_bytes({0xd5, 0x18, 0x83, 0xfe, 0x00},                   cmp_r64i8, r22, (s8)0);
+		check_bytes({0xd5, 0x10, 0x83, 0xc0, 0xff},                   add_r32i8, r16d, (s8)-1);
+		check_bytes({0xd5, 0x11, 0x83, 0xfd, 0x7f},                   cmp_r32i8, r29d, (s8)0x7f);
+		check_bytes({0xd5, 0x11, 0xc1, 0xe1, 0x04},                   shl_r32i8, r25d, 4);
+
+		// r16-r31 and xmm16-31 where they can't be encoded
+		check_rejected(crc32_r32r32,    r16d, eax);
+		check_rejected(addpd_xx,        xmm16, xmm0);
+		check_rejected(vpgatherdd_xvx,  xmm1, vsib64_bi(r16, xmm2, 4), xmm3);
+		check_rejected(vgatherdps_zkv,  zmm1, k1, vsib64_bi(r16, zmm2, 4));
+		check_rejected(vpscatterdd_vkz, vsib64_bi(r31, zmm2, 4), k1, zmm1);
+	} while (0);
+
 	return 0;
 }
\ No newline at end of file
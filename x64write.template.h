@@ -25,6 +25,22 @@ focused on static typechecking.
 	which will reduce code size, but might have worse performance.
 
 	If none of the inlining macros are defined, it's up to the compiler to decide.
+
+#define X64W_MINIMAL
+	To include only the base instruction set. Every instruction set extension is then opt-in,
+	which keeps the amount of code each translation unit has to parse small:
+#define X64W_ENABLE_SSE
+#define X64W_ENABLE_AVX
+#define X64W_ENABLE_AVX512
+#define X64W_ENABLE_ADX
+#define X64W_ENABLE_BMI
+#define X64W_ENABLE_FMA
+#define X64W_ENABLE_CRYPTO
+#define X64W_ENABLE_APX
+	Translation unit with X64W_IMPLEMENTATION has to enable every extension used in the program.
+#define X64W_ENABLE_FORMS
+	To include x64w_Form, x64w_encode and x64w_form_info in a minimal build.
+	Translation unit with X64W_IMPLEMENTATION has to enable them if any translation unit uses them.
 	
 		Errors:
 
@@ -55,18 +71,33 @@ i - immediate
 x - xmm register
 y - ymm register
 z - zmm register
+k - opmask register, as a mask it follows the destination
+b - memory operand holding one element, broadcast to every element
+v - memory with vector index (VSIB) of gathers and scatters
+
+	Masked forms with _z at the end zero the masked out elements instead of keeping them.
 
 	Size may not be required if it is obvious in the mnemonic
 
 	Example:
-sub_r64i32 - subtract 32-bit immediate from 64-bit register
-addpd_xx   - add 64-bit floats in xmm registers
+sub_r64i32    - subtract 32-bit immediate from 64-bit register
+addpd_xx      - add 64-bit floats in xmm registers
+vaddpd_zkzb_z - vaddpd zmm {k} {z}, zmm, m64bcst
+rep_movsb     - movsb with rep prefix, string instructions take no operands
+lock_add_mr64 - add_mr64 with lock prefix, only forms with memory destination can be locked
+add_rrm64     - add [m64] to second register and write to the first one (APX new data destination)
+
+	Registers r16-r31 (APX) are encoded with REX2 in legacy forms, there is no r16b-r31b.
+	They are rejected unless APX is enabled.
+	VEX and EVEX forms can't use them.
 
 
 	Memory operand naming: suffix of mem_* determines argument type and count
 b - base register
 i - index register, index scale (1/2/4/8)
-d - 32-bit displacement
+	vsib* use the same suffixes, index is a vector register of the size the form expects
+	vsib* use the same suffixes, index is a vector register
+	mem_fs(m) and mem_gs(m) add a segment override to memory operand m
 
 		TODO
 	Choose compact instructions when available?
@@ -107,6 +138,55 @@ d - 32-bit displacement
 
 #define X64W_MAX_INSTRUCTION_SIZE 15
 
+// Set to 1 if extension's functions are included, 0 otherwise.
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_SSE)
+	#define X64W_EXT_SSE 1
+#else
+	#define X64W_EXT_SSE 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_AVX)
+	#define X64W_EXT_AVX 1
+#else
+	#define X64W_EXT_AVX 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_AVX512)
+	#define X64W_EXT_AVX512 1
+#else
+	#define X64W_EXT_AVX512 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_ADX)
+	#define X64W_EXT_ADX 1
+#else
+	#define X64W_EXT_ADX 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_BMI)
+	#define X64W_EXT_BMI 1
+#else
+	#define X64W_EXT_BMI 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_FMA)
+	#define X64W_EXT_FMA 1
+#else
+	#define X64W_EXT_FMA 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_CRYPTO)
+	#define X64W_EXT_CRYPTO 1
+#else
+	#define X64W_EXT_CRYPTO 0
+#endif
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_APX)
+	#define X64W_EXT_APX 1
+#else
+	#define X64W_EXT_APX 0
+#endif
+
+// Set to 1 if x64w_Form, x64w_encode and x64w_form_info are included, 0 otherwise.
+#if !defined(X64W_MINIMAL) || defined(X64W_ENABLE_FORMS)
+	#define X64W_FORMS 1
+#else
+	#define X64W_FORMS 0
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -154,6 +234,22 @@ typedef struct { uint8_t i; } x64w_Gpr16;
 #define x64w_r13w (X64W_LIT(x64w_Gpr16) { 0x0d })
 #define x64w_r14w (X64W_LIT(x64w_Gpr16) { 0x0e })
 #define x64w_r15w (X64W_LIT(x64w_Gpr16) { 0x0f })
+#define x64w_r16w (X64W_LIT(x64w_Gpr16) { 0x10 })
+#define x64w_r17w (X64W_LIT(x64w_Gpr16) { 0x11 })
+#define x64w_r18w (X64W_LIT(x64w_Gpr16) { 0x12 })
+#define x64w_r19w (X64W_LIT(x64w_Gpr16) { 0x13 })
+#define x64w_r20w (X64W_LIT(x64w_Gpr16) { 0x14 })
+#define x64w_r21w (X64W_LIT(x64w_Gpr16) { 0x15 })
+#define x64w_r22w (X64W_LIT(x64w_Gpr16) { 0x16 })
+#define x64w_r23w (X64W_LIT(x64w_Gpr16) { 0x17 })
+#define x64w_r24w (X64W_LIT(x64w_Gpr16) { 0x18 })
+#define x64w_r25w (X64W_LIT(x64w_Gpr16) { 0x19 })
+#define x64w_r26w (X64W_LIT(x64w_Gpr16) { 0x1a })
+#define x64w_r27w (X64W_LIT(x64w_Gpr16) { 0x1b })
+#define x64w_r28w (X64W_LIT(x64w_Gpr16) { 0x1c })
+#define x64w_r29w (X64W_LIT(x64w_Gpr16) { 0x1d })
+#define x64w_r30w (X64W_LIT(x64w_Gpr16) { 0x1e })
+#define x64w_r31w (X64W_LIT(x64w_Gpr16) { 0x1f })
 
 typedef struct { uint8_t i; } x64w_Gpr32;
 #define x64w_eax  (X64W_LIT(x64w_Gpr32) { 0x00 })
@@ -172,6 +268,22 @@ typedef struct { uint8_t i; } x64w_Gpr32;
 #define x64w_r13d (X64W_LIT(x64w_Gpr32) { 0x0d })
 #define x64w_r14d (X64W_LIT(x64w_Gpr32) { 0x0e })
 #define x64w_r15d (X64W_LIT(x64w_Gpr32) { 0x0f })
+#define x64w_r16d (X64W_LIT(x64w_Gpr32) { 0x10 })
+#define x64w_r17d (X64W_LIT(x64w_Gpr32) { 0x11 })
+#define x64w_r18d (X64W_LIT(x64w_Gpr32) { 0x12 })
+#define x64w_r19d (X64W_LIT(x64w_Gpr32) { 0x13 })
+#define x64w_r20d (X64W_LIT(x64w_Gpr32) { 0x14 })
+#define x64w_r21d (X64W_LIT(x64w_Gpr32) { 0x15 })
+#define x64w_r22d (X64W_LIT(x64w_Gpr32) { 0x16 })
+#define x64w_r23d (X64W_LIT(x64w_Gpr32) { 0x17 })
+#define x64w_r24d (X64W_LIT(x64w_Gpr32) { 0x18 })
+#define x64w_r25d (X64W_LIT(x64w_Gpr32) { 0x19 })
+#define x64w_r26d (X64W_LIT(x64w_Gpr32) { 0x1a })
+#define x64w_r27d (X64W_LIT(x64w_Gpr32) { 0x1b })
+#define x64w_r28d (X64W_LIT(x64w_Gpr32) { 0x1c })
+#define x64w_r29d (X64W_LIT(x64w_Gpr32) { 0x1d })
+#define x64w_r30d (X64W_LIT(x64w_Gpr32) { 0x1e })
+#define x64w_r31d (X64W_LIT(x64w_Gpr32) { 0x1f })
 
 typedef struct { uint8_t i; } x64w_Gpr64;
 #define x64w_rax  (X64W_LIT(x64w_Gpr64) { 0x00 })
@@ -190,6 +302,22 @@ typedef struct { uint8_t i; } x64w_Gpr64;
 #define x64w_r13  (X64W_LIT(x64w_Gpr64) { 0x0d })
 #define x64w_r14  (X64W_LIT(x64w_Gpr64) { 0x0e })
 #define x64w_r15  (X64W_LIT(x64w_Gpr64) { 0x0f })
+#define x64w_r16  (X64W_LIT(x64w_Gpr64) { 0x10 })
+#define x64w_r17  (X64W_LIT(x64w_Gpr64) { 0x11 })
+#define x64w_r18  (X64W_LIT(x64w_Gpr64) { 0x12 })
+#define x64w_r19  (X64W_LIT(x64w_Gpr64) { 0x13 })
+#define x64w_r20  (X64W_LIT(x64w_Gpr64) { 0x14 })
+#define x64w_r21  (X64W_LIT(x64w_Gpr64) { 0x15 })
+#define x64w_r22  (X64W_LIT(x64w_Gpr64) { 0x16 })
+#define x64w_r23  (X64W_LIT(x64w_Gpr64) { 0x17 })
+#define x64w_r24  (X64W_LIT(x64w_Gpr64) { 0x18 })
+#define x64w_r25  (X64W_LIT(x64w_Gpr64) { 0x19 })
+#define x64w_r26  (X64W_LIT(x64w_Gpr64) { 0x1a })
+#define x64w_r27  (X64W_LIT(x64w_Gpr64) { 0x1b })
+#define x64w_r28  (X64W_LIT(x64w_Gpr64) { 0x1c })
+#define x64w_r29  (X64W_LIT(x64w_Gpr64) { 0x1d })
+#define x64w_r30  (X64W_LIT(x64w_Gpr64) { 0x1e })
+#define x64w_r31  (X64W_LIT(x64w_Gpr64) { 0x1f })
 
 typedef struct { uint8_t i; } x64w_Xmm;
 #define x64w_xmm0  (X64W_LIT(x64w_Xmm) { 0x00 })
@@ -293,20 +421,78 @@ typedef struct { uint8_t i; } x64w_Zmm;
 #define x64w_zmm30 (X64W_LIT(x64w_Zmm) { 0x1e })
 #define x64w_zmm31 (X64W_LIT(x64w_Zmm) { 0x1f })
 
+// AVX-512 opmask registers. k0 can't be used as a mask, it means no masking.
+typedef struct { uint8_t i; } x64w_Kreg;
+#define x64w_k0 (X64W_LIT(x64w_Kreg) { 0x00 })
+#define x64w_k1 (X64W_LIT(x64w_Kreg) { 0x01 })
+#define x64w_k2 (X64W_LIT(x64w_Kreg) { 0x02 })
+#define x64w_k3 (X64W_LIT(x64w_Kreg) { 0x03 })
+#define x64w_k4 (X64W_LIT(x64w_Kreg) { 0x04 })
+#define x64w_k5 (X64W_LIT(x64w_Kreg) { 0x05 })
+#define x64w_k6 (X64W_LIT(x64w_Kreg) { 0x06 })
+#define x64w_k7 (X64W_LIT(x64w_Kreg) { 0x07 })
+
+// Condition code of setcc, cmovcc and jcc, in encoding order.
+// Alternative names are provided where they are commonly used.
+typedef enum x64w_Cond X64W_UNDERLYING(uint8_t) {
+	x64w_cond_o   = 0x0,
+	x64w_cond_no  = 0x1,
+	x64w_cond_b   = 0x2,
+	x64w_cond_ae  = 0x3,
+	x64w_cond_e   = 0x4,
+	x64w_cond_ne  = 0x5,
+	x64w_cond_be  = 0x6,
+	x64w_cond_a   = 0x7,
+	x64w_cond_s   = 0x8,
+	x64w_cond_ns  = 0x9,
+	x64w_cond_p   = 0xa,
+	x64w_cond_np  = 0xb,
+	x64w_cond_l   = 0xc,
+	x64w_cond_ge  = 0xd,
+	x64w_cond_le  = 0xe,
+	x64w_cond_g   = 0xf,
+
+	x64w_cond_c   = x64w_cond_b,
+	x64w_cond_nc  = x64w_cond_ae,
+	x64w_cond_z   = x64w_cond_e,
+	x64w_cond_nz  = x64w_cond_ne,
+	x64w_cond_na  = x64w_cond_be,
+	x64w_cond_nbe = x64w_cond_a,
+	x64w_cond_pe  = x64w_cond_p,
+	x64w_cond_po  = x64w_cond_np,
+	x64w_cond_nge = x64w_cond_l,
+	x64w_cond_nl  = x64w_cond_ge,
+	x64w_cond_ng  = x64w_cond_le,
+	x64w_cond_nle = x64w_cond_g,
+} x64w_Cond;
+
 // Use x64w_mem_* macros to construct this.
 // This will ensure correct initialization.
+// Segment override prefix is 0x63 + segment. Only fs and gs have a non-zero base in 64-bit mode.
+enum x64w_Segment {
+	x64w_seg_none = 0,
+	x64w_seg_fs   = 1,
+	x64w_seg_gs   = 2,
+};
+
 typedef struct x64w_Mem {
-	uint8_t base : 4;
-	uint8_t index : 4;
+	uint8_t base : 5;
+	uint8_t index : 5;
 	uint8_t base_scale : 1;
 	uint8_t index_scale : 4; // allowed 0, 1, 2, 4 or 8
 	uint8_t size_override : 1;
+	uint8_t segment : 2; // x64w_Segment
 	int32_t displacement;
 } x64w_Mem;
 
 inline uint8_t x64w_ensure_arg_is_gpr32(x64w_Gpr32 r) { return r.i; }
 inline uint8_t x64w_ensure_arg_is_gpr64(x64w_Gpr64 r) { return r.i; }
 
+// Same memory operand relative to fs or gs base, used for thread-local storage:
+// x64w_mem_fs(x64w_mem64_d(0x28)) is fs:[0x28]
+inline x64w_Mem x64w_mem_fs(x64w_Mem m) { m.segment = x64w_seg_fs; return m; }
+inline x64w_Mem x64w_mem_gs(x64w_Mem m) { m.segment = x64w_seg_gs; return m; }
+
 // Suffix determines argument type and count:
 //     b - base register
 //     i - index register + index scale constant
@@ -381,6 +567,73 @@ inline uint8_t x64w_ensure_arg_is_gpr64(x64w_Gpr64 r) { return r.i; }
 #define x64w_mem64_id(i, is, d)     _x64w_mem_id(64, 0, i, is, d)
 #define x64w_mem64_bid(b, i, is, d) _x64w_mem_bid(64, 0, b, i, is, d)
 
+// Memory operand of gathers and scatters: base + index[n] * scale + displacement.
+// Index is a vector register, it has to be of the size the instruction form expects:
+// as large as the data register, or half of it for dword indices of qword elements.
+// Use x64w_vsib* macros to construct this.
+typedef struct x64w_Vsib {
+	uint8_t base : 5;
+	uint8_t index : 5;
+	uint8_t index_size : 2; // 0 - xmm, 1 - ymm, 2 - zmm
+	uint8_t base_scale : 1;
+	uint8_t index_scale : 4; // allowed 1, 2, 4 or 8
+	uint8_t size_override : 1;
+	int32_t displacement;
+} x64w_Vsib;
+
+#ifdef __cplusplus
+extern "C++" {
+inline uint8_t x64w_ensure_arg_is_vec(x64w_Xmm r) { return r.i; }
+inline uint8_t x64w_ensure_arg_is_vec(x64w_Ymm r) { return r.i; }
+inline uint8_t x64w_ensure_arg_is_vec(x64w_Zmm r) { return r.i; }
+inline uint8_t x64w_vec_index_size(x64w_Xmm) { return 0; }
+inline uint8_t x64w_vec_index_size(x64w_Ymm) { return 1; }
+inline uint8_t x64w_vec_index_size(x64w_Zmm) { return 2; }
+}
+#else
+#define x64w_ensure_arg_is_vec(x) _Generic((x), x64w_Xmm: (x).i, x64w_Ymm: (x).i, x64w_Zmm: (x).i)
+#define x64w_vec_index_size(x)    _Generic((x), x64w_Xmm: 0, x64w_Ymm: 1, x64w_Zmm: 2)
+#endif
+
+// Index can be x64w_Xmm, x64w_Ymm or x64w_Zmm.
+#define _x64w_vsib_bi(size, so, b, x, is)                            \
+	X64W_LIT(x64w_Vsib) {                                            \
+		.base = x64w_ensure_arg_is_gpr##size(b),                     \
+		.index = x64w_ensure_arg_is_vec(x),                          \
+		.index_size = x64w_vec_index_size(x),                        \
+		.base_scale = 1,                                             \
+		.index_scale = is,                                           \
+		.size_override = so,                                         \
+	}
+
+#define _x64w_vsib_id(size, so, x, is, d)                            \
+	X64W_LIT(x64w_Vsib) {                                            \
+		.index = x64w_ensure_arg_is_vec(x),                          \
+		.index_size = x64w_vec_index_size(x),                        \
+		.index_scale = is,                                           \
+		.size_override = so,                                         \
+		.displacement = d,                                           \
+	}
+
+#define _x64w_vsib_bid(size, so, b, x, is, d)                        \
+	X64W_LIT(x64w_Vsib) {                                            \
+		.base = x64w_ensure_arg_is_gpr##size(b),                     \
+		.index = x64w_ensure_arg_is_vec(x),                          \
+		.index_size = x64w_vec_index_size(x),                        \
+		.base_scale = 1,                                             \
+		.index_scale = is,                                           \
+		.size_override = so,                                         \
+		.displacement = d,                                           \
+	}
+
+#define x64w_vsib32_bi(b, x, is)     _x64w_vsib_bi(32, 1, b, x, is)
+#define x64w_vsib32_id(x, is, d)     _x64w_vsib_id(32, 1, x, is, d)
+#define x64w_vsib32_bid(b, x, is, d) _x64w_vsib_bid(32, 1, b, x, is, d)
+
+#define x64w_vsib64_bi(b, x, is)     _x64w_vsib_bi(64, 0, b, x, is)
+#define x64w_vsib64_id(x, is, d)     _x64w_vsib_id(64, 0, x, is, d)
+#define x64w_vsib64_bid(b, x, is, d) _x64w_vsib_bid(64, 0, b, x, is, d)
+
 enum x64w_DisplacementForm {
 	x64w_df_no    = 0,
 	x64w_df_8bit  = 1,
@@ -396,47 +649,141 @@ X64W_DEF x64w_DisplacementForm x64w_displacement_form(x64w_Mem m);
 X64W_DEF bool x64w_gpr8_compatible_rr(x64w_Gpr8 a, x64w_Gpr8 b);
 X64W_DEF bool x64w_gpr8_compatible_rm(x64w_Gpr8 a, x64w_Mem b);
 
-X64W_DEF x64w_Result x64w_push_i8 (uint8_t **c, int8_t   i);
-X64W_DEF x64w_Result x64w_push_i32(uint8_t **c, int32_t  i);
-X64W_DEF x64w_Result x64w_push_r16(uint8_t **c, x64w_Gpr16 r);
-X64W_DEF x64w_Result x64w_push_r64(uint8_t **c, x64w_Gpr64 r);
-X64W_DEF x64w_Result x64w_push_m16(uint8_t **c, x64w_Mem m);
-X64W_DEF x64w_Result x64w_push_m64(uint8_t **c, x64w_Mem m);
-
-X64W_DEF x64w_Result x64w_pop_r16(uint8_t **c, x64w_Gpr16 r);
-X64W_DEF x64w_Result x64w_pop_r64(uint8_t **c, x64w_Gpr64 r);
-X64W_DEF x64w_Result x64w_pop_m16(uint8_t **c, x64w_Mem m);
-X64W_DEF x64w_Result x64w_pop_m64(uint8_t **c, x64w_Mem m);
-
-X64W_DEF x64w_Result x64w_mov_ri8 (uint8_t **c, x64w_Gpr8  r, int8_t  i);
-X64W_DEF x64w_Result x64w_mov_ri16(uint8_t **c, x64w_Gpr16 r, int16_t i);
-X64W_DEF x64w_Result x64w_mov_ri32(uint8_t **c, x64w_Gpr32 r, int32_t i);
-X64W_DEF x64w_Result x64w_mov_ri64(uint8_t **c, x64w_Gpr64 r, int64_t i);
-X64W_DEF x64w_Result x64w_mov_rr8 (uint8_t **c, x64w_Gpr8  d, x64w_Gpr8  s);
-X64W_DEF x64w_Result x64w_mov_rr16(uint8_t **c, x64w_Gpr16 d, x64w_Gpr16 s);
-X64W_DEF x64w_Result x64w_mov_rr32(uint8_t **c, x64w_Gpr32 d, x64w_Gpr32 s);
-X64W_DEF x64w_Result x64w_mov_rr64(uint8_t **c, x64w_Gpr64 d, x64w_Gpr64 s);
-X64W_DEF x64w_Result x64w_mov_rm8 (uint8_t **c, x64w_Gpr8  r, x64w_Mem m);
-X64W_DEF x64w_Result x64w_mov_rm16(uint8_t **c, x64w_Gpr16 r, x64w_Mem m);
-X64W_DEF x64w_Result x64w_mov_rm32(uint8_t **c, x64w_Gpr32 r, x64w_Mem m);
-X64W_DEF x64w_Result x64w_mov_rm64(uint8_t **c, x64w_Gpr64 r, x64w_Mem m);
-X64W_DEF x64w_Result x64w_mov_mi8 (uint8_t **c, x64w_Mem m, int8_t  i);
-X64W_DEF x64w_Result x64w_mov_mi16(uint8_t **c, x64w_Mem m, int16_t i);
-X64W_DEF x64w_Result x64w_mov_mi32(uint8_t **c, x64w_Mem m, int32_t i);
-X64W_DEF x64w_Result x64w_mov_m64i32(uint8_t **c, x64w_Mem m, int32_t i);
-X64W_DEF x64w_Result x64w_mov_mr8 (uint8_t **c, x64w_Mem m, x64w_Gpr8  r);
-X64W_DEF x64w_Result x64w_mov_mr16(uint8_t **c, x64w_Mem m, x64w_Gpr16 r);
-X64W_DEF x64w_Result x64w_mov_mr32(uint8_t **c, x64w_Mem m, x64w_Gpr32 r);
-X64W_DEF x64w_Result x64w_mov_mr64(uint8_t **c, x64w_Mem m, x64w_Gpr64 r);
-
-X64W_DEF x64w_Result x64w_adcx_rr32(uint8_t **c, x64w_Gpr32 d, x64w_Gpr32 s);
-X64W_DEF x64w_Result x64w_adcx_rr64(uint8_t **c, x64w_Gpr64 d, x64w_Gpr64 s);
+#if X64W_FORMS
+
+// Operand of x64w_encode. Member that is used is determined by parameter type of the form:
+//     r - any register
+//     m - memory
+//     v - memory with vector index
+//     i - immediate or condition
+typedef union x64w_Operand {
+	uint8_t   r;
+	x64w_Mem  m;
+	x64w_Vsib v;
+	int64_t   i;
+} x64w_Operand;
+
+#define x64w_operand_r(reg) (X64W_LIT(x64w_Operand) { .r = (reg).i })
+#define x64w_operand_m(mem) (X64W_LIT(x64w_Operand) { .m = (mem) })
+#define x64w_operand_v(mem) (X64W_LIT(x64w_Operand) { .v = (mem) })
+#define x64w_operand_i(imm) (X64W_LIT(x64w_Operand) { .i = (imm) })
+
+// x64w_form_<name> corresponds to x64w_<name> function.
+// Values are the same regardless of enabled extensions.
+INSERT_FORMS
+
+// Encodes instruction form chosen at runtime. Operands are passed in the same order
+// as to x64w_<name> function. Dispatches through a table, without branching on form.
+X64W_DEF x64w_Result x64w_encode(uint8_t **c, x64w_Form form, x64w_Operand const *operands);
+
+typedef enum x64w_OperandKind X64W_UNDERLYING(uint8_t) {
+	x64w_kind_gpr8,
+	x64w_kind_gpr16,
+	x64w_kind_gpr32,
+	x64w_kind_gpr64,
+	x64w_kind_xmm,
+	x64w_kind_ymm,
+	x64w_kind_zmm,
+	x64w_kind_kreg,
+	x64w_kind_mem,
+	x64w_kind_vsib,
+	x64w_kind_cond,
+	x64w_kind_imm8,
+	x64w_kind_imm16,
+	x64w_kind_imm32,
+	x64w_kind_imm64,
+} x64w_OperandKind;
+
+typedef enum x64w_Access X64W_UNDERLYING(uint8_t) {
+	x64w_access_none       = 0, // Only address of memory operand is used (lea)
+	x64w_access_read       = 1,
+	x64w_access_write      = 2,
+	x64w_access_read_write = 3,
+} x64w_Access;
+
+// Bits of RFLAGS, at the same positions as in the register.
+#define x64w_flag_cf 0x0001
+#define x64w_flag_pf 0x0004
+#define x64w_flag_af 0x0010
+#define x64w_flag_zf 0x0040
+#define x64w_flag_sf 0x0080
+#define x64w_flag_df 0x0400
+#define x64w_flag_of 0x0800
+
+// Bit N corresponds to general purpose register with index N.
+#define x64w_mask_rax 0x0001
+#define x64w_mask_rcx 0x0002
+#define x64w_mask_rdx 0x0004
+#define x64w_mask_rbx 0x0008
+#define x64w_mask_rsp 0x0010
+#define x64w_mask_rbp 0x0020
+#define x64w_mask_rsi 0x0040
+#define x64w_mask_rdi 0x0080
+#define x64w_mask_r8  0x0100
+#define x64w_mask_r9  0x0200
+#define x64w_mask_r10 0x0400
+#define x64w_mask_r11 0x0800
+#define x64w_mask_r12 0x1000
+#define x64w_mask_r13 0x2000
+#define x64w_mask_r14 0x4000
+#define x64w_mask_r15 0x8000
+
+// Bit N corresponds to vector register with index N, of any width.
+#define x64w_mask_xmm0  0x0001
+#define x64w_mask_xmm1  0x0002
+#define x64w_mask_xmm2  0x0004
+#define x64w_mask_xmm3  0x0008
+#define x64w_mask_xmm4  0x0010
+#define x64w_mask_xmm5  0x0020
+#define x64w_mask_xmm6  0x0040
+#define x64w_mask_xmm7  0x0080
+#define x64w_mask_xmm8  0x0100
+#define x64w_mask_xmm9  0x0200
+#define x64w_mask_xmm10 0x0400
+#define x64w_mask_xmm11 0x0800
+#define x64w_mask_xmm12 0x1000
+#define x64w_mask_xmm13 0x2000
+#define x64w_mask_xmm14 0x4000
+#define x64w_mask_xmm15 0x8000
+
+// What an instruction form reads and writes, generated together with the encoders.
+// Writes to 8 and 16 bit registers keep the rest of the register intact.
+// Shifts by zero leave the flags unmodified, so shifts by cl or imm8 also read the flags they modify.
+// Forms with a condition operand read every flag that a condition can test.
+typedef struct x64w_FormInfo {
+	char const *mnemonic;
+	uint8_t operand_count;
+	uint8_t operand_kinds[4];  // x64w_OperandKind
+	uint8_t operand_access[4]; // x64w_Access
+	uint16_t implicit_read;    // x64w_mask_*, registers that are not operands
+	uint16_t implicit_write;   // x64w_mask_*
+	uint16_t implicit_vector_read;  // x64w_mask_xmm*, vector registers that are not operands
+	uint16_t implicit_vector_write; // x64w_mask_xmm*
+	uint16_t flags_read;       // x64w_flag_*
+	uint16_t flags_written;    // x64w_flag_*, set to a defined value
+	uint16_t flags_undefined;  // x64w_flag_*, modified, but value is undefined
+} x64w_FormInfo;
+
+// Returns 0 if form is invalid. Available for forms of disabled extensions too.
+X64W_DEF x64w_FormInfo const *x64w_form_info(x64w_Form form);
+
+#endif // X64W_FORMS
+
+// Single nop instruction of `n` bytes, 0 to X64W_MAX_INSTRUCTION_SIZE.
+// Nops longer than 9 bytes are the 9-byte one with extra 66 prefixes.
+X64W_DEF x64w_Result x64w_nop(uint8_t **c, unsigned n);
+
+// Pads with nops until *c is a multiple of `boundary`, which has to be a power of two.
+// Alignment is of the address being written to, so code has to run where it's written.
+X64W_DEF x64w_Result x64w_align(uint8_t **c, unsigned boundary);
 
 INSERT_FUNCTION_DECLARATIONS
 
 #ifdef X64W_IMPLEMENTATION
 
 #define X64W_GPR8_NEEDS_REX(gpr) (!!((gpr) & 0x10))
+// Register number for REX/REX2, 8-bit registers 0x14-0x17 (spl-dil) are numbers 4-7.
+#define X64W_REG(r, size) ((size) == 1 ? (r) & 15 : (r))
 
 #ifndef X64W_VALIDATE
 #define X64W_VALIDATE(condition, message) do { if (!(condition)) { *c = restore; return message; } } while (0)
@@ -456,17 +803,36 @@ bool x64w_gpr8_compatible_rm(x64w_Gpr8 a, x64w_Mem b) {
 	#define X64W_VALIDATE(condition, message)
 	#define X64W_VALIDATE_R(r)
 	#define X64W_VALIDATE_M(m)
+	#define X64W_VALIDATE_V(m)
+	#define X64W_VALIDATE_CC(cc)
+	#define X64W_VALIDATE_K(k)
+	#define X64W_VALIDATE_LOW(r)
+	#define X64W_VALIDATE_REX2(opcode, regs)
 #else
 
+// r16-r31 are encoded with REX2 or extended EVEX, only APX capable processors support them
+#if X64W_EXT_APX
+	#define X64W_GPR_LIMIT 0x20
+#else
+	#define X64W_GPR_LIMIT 0x10
+#endif
+
 #define X64W_VALIDATE_R(r)                                                           \
 	do {                                                                             \
 		if (size == 1) {                                                             \
 			X64W_VALIDATE(r < 0x10 || (0x14 <= r && r < 0x18), "invalid register");  \
 		} else {                                                                     \
-			X64W_VALIDATE(r < 0x10, "invalid register");                             \
+			X64W_VALIDATE(r < X64W_GPR_LIMIT, "invalid register");                   \
 		}                                                                            \
 	} while (0)
 
+// Registers 16-31 of forms and encodings that don't support them
+#define X64W_VALIDATE_LOW(r) X64W_VALIDATE((r) < 0x10, "registers 16-31 can't be used in this form")
+
+// REX2 can't encode 0f38 and 0f3a opcodes
+#define X64W_VALIDATE_REX2(opcode, regs) \
+	X64W_VALIDATE((opcode) <= 0xffff || !((regs) & 0x10), "r16-r31 can't be used with this instruction")
+
 #define X64W_VALIDATE_M(m)                                                                     \
 	do {                                                                                       \
 		if (m.base_scale == 0) {                                                               \
@@ -484,6 +850,21 @@ bool x64w_gpr8_compatible_rm(x64w_Gpr8 a, x64w_Mem b) {
 		} else {                                                                               \
 			X64W_VALIDATE(m.index == 0, "index register should be zero if its scale is zero"); \
 		}                                                                                      \
+		X64W_VALIDATE(m.segment <= x64w_seg_gs, "invalid segment");                            \
+		X64W_VALIDATE((m.base | m.index) < X64W_GPR_LIMIT, "invalid register");                \
+	} while (0)
+
+#define X64W_VALIDATE_V(m)                                                                     \
+	do {                                                                                       \
+		if (m.base_scale == 0) {                                                               \
+			X64W_VALIDATE(m.base == 0, "base register should be zero if its scale is zero");   \
+		}                                                                                      \
+		X64W_VALIDATE(                                                                         \
+			m.index_scale == 1 ||                                                              \
+			m.index_scale == 2 ||                                                              \
+			m.index_scale == 4 ||                                                              \
+			m.index_scale == 8, "invalid index scale"                                          \
+		);                                                                                     \
 	} while (0)
 
 #define X64W_VALIDATE_RR(a, b)                                                                     \
@@ -506,11 +887,11 @@ bool x64w_gpr8_compatible_rm(x64w_Gpr8 a, x64w_Mem b) {
 		}                                                                     \
 	} while (0)
 
-#define X64W_VALIDATE_X(x)                                           \
-	do {                                                             \
-		if (size == 64) X64W_VALIDATE(x < 0x10, "invalid register"); \
-		else            X64W_VALIDATE(x < 0x20, "invalid register"); \
-	} while (0)
+#define X64W_VALIDATE_CC(cc) X64W_VALIDATE((unsigned)(cc) < 0x10, "invalid condition")
+
+#define X64W_VALIDATE_K(k) X64W_VALIDATE((k) < 8, "invalid opmask register")
+
+#define X64W_VALIDATE_X(x) X64W_VALIDATE(x < 0x20, "invalid register")
 
 #endif
 
@@ -556,6 +937,13 @@ bool x64w_gpr8_compatible_rm(x64w_Gpr8 a, x64w_Mem b) {
 #define OSO      0x2 // operand size override
 #define ASO      0x4 // address size override
 #define NO_MODRM 0x8
+#define REP      0x10 // f3 prefix (rep/repe), also used as a mandatory prefix
+#define REPNE    0x20 // f2 prefix (repne), also used as a mandatory prefix
+#define EVEXW    0x40 // W is set only in EVEX encoding, for instructions that ignore it in VEX
+#define ZEROING  0x80 // EVEX.z, zero masked out elements
+#define BCST     0x100 // EVEX.b, broadcast one element of memory operand
+#define T1S      0x200 // EVEX tuple type of scalar instructions, memory operand is one element
+#define LOCK     0x400 // f0 prefix, atomic read-modify-write of the memory operand
 
 #define vex_m_0f   1
 #define vex_m_0f38 2
@@ -592,6 +980,7 @@ static void write_rex(uint8_t **c, bool w, bool r, bool i, bool b, bool force) {
 	**c = 0x40 | (w << 3) | (r << 2) | (i << 1) | (int)b;
 	*c += w | r | i | b | force;
 }
+#if X64W_EXT_AVX || X64W_EXT_AVX512 || X64W_EXT_FMA || X64W_EXT_CRYPTO || X64W_EXT_BMI
 static void write_vex2(uint8_t **c, bool r, uint8_t v, bool l, uint8_t p) {
 	*(*c)++ = 0xc5;
 	*(*c)++ = (!r << 7) | ((v ^ 0xf) << 3) | (l << 2) | p;
@@ -599,21 +988,50 @@ static void write_vex2(uint8_t **c, bool r, uint8_t v, bool l, uint8_t p) {
 static void write_vex3(uint8_t **c, bool r, bool x, bool b, uint8_t m, bool w, uint8_t v, bool l, uint8_t p) {
 	*(*c)++ = 0xc4;
 	*(*c)++ = (!r << 7) | (!x << 6) | (!b << 5) | m;
-	*(*c)++ = (!w << 7) | ((v ^ 0xf) << 3) | (l << 2) | p;
+	*(*c)++ = (w << 7) | ((v ^ 0xf) << 3) | (l << 2) | p;
 }
 static void write_vex(uint8_t **c, bool r, bool x, bool b, uint8_t m, bool w, uint8_t v, bool l, uint8_t p) {
-	if (x | b | w) {
+	// Two byte form implies 0F map
+	if (x | b | w | (m != vex_m_0f)) {
 		write_vex3(c, r, x, b, m, w, v, l, p);
 	} else {
 		write_vex2(c, r, v, l, p);
 	}
 }
+// Map is a part of the opcode: 0x0fxx, 0x0f38xx or 0x0f3axx
+static uint8_t vex_map(uint32_t opcode) {
+	switch (opcode >> 8) {
+		case 0x0f38: return vex_m_0f38;
+		case 0x0f3a: return vex_m_0f3a;
+		default:     return vex_m_0f;
+	}
+}
+// pp is a compressed legacy prefix
+static uint8_t vex_pp(uint64_t flags) {
+	if (flags & OSO)   return vex_p_66;
+	if (flags & REP)   return vex_p_f3;
+	if (flags & REPNE) return vex_p_f2;
+	return vex_p_none;
+}
+#endif
+#if X64W_EXT_AVX || X64W_EXT_AVX512 || X64W_EXT_FMA || X64W_EXT_CRYPTO
 static void write_evex(uint8_t **c, bool R, bool X, bool B, bool Rh, uint8_t m, bool W, uint8_t v, uint8_t p, bool z, uint8_t L, bool b, bool vh, uint8_t a) {
 	*(*c)++ = 0x62;
 	*(*c)++ = (!R << 7) | (!X << 6) | (!B << 5) | (!Rh << 4) | m;
 	*(*c)++ = (W << 7) | ((v ^ 0xf) << 3) | 0x04 | p;
 	*(*c)++ = (z << 7) | (L << 5) | (b << 4) | (!vh << 3) | a;
 }
+#endif
+#if X64W_EXT_APX
+// Extended EVEX of legacy instructions promoted to map 4. r, x, b and v are full register numbers,
+// bit 4 of b is the only one that isn't inverted. nd makes v the destination, leaving r/m operand intact.
+static void write_evex_map4(uint8_t **c, unsigned r, unsigned x, unsigned b, unsigned v, bool w, uint8_t p, bool nd) {
+	*(*c)++ = 0x62;
+	*(*c)++ = (!(r & 8) << 7) | (!(x & 8) << 6) | (!(b & 8) << 5) | (!(r & 16) << 4) | (!!(b & 16) << 3) | 0x04;
+	*(*c)++ = (w << 7) | ((~v & 0xf) << 3) | (!(x & 16) << 2) | p;
+	*(*c)++ = (nd << 4) | (!(v & 16) << 3);
+}
+#endif
 static void write_opcode(uint8_t **c, uint32_t opcode) {
 	if (opcode <= 0xff) {
 		*(*c)++ = opcode;
@@ -626,17 +1044,29 @@ static void write_opcode(uint8_t **c, uint32_t opcode) {
 		*(*c)++ = opcode & 0xff;
 	}
 }
+// REX2 (APX) replaces REX if any of the registers is r16-r31, it also replaces the 0f escape byte.
+// r, i, b are full register numbers.
+static void write_rex_opcode(uint8_t **c, bool w, unsigned r, unsigned i, unsigned b, bool force, uint32_t opcode) {
+	if ((r | i | b) & 16) {
+		*(*c)++ = 0xd5;
+		*(*c)++ = ((opcode > 0xff) << 7) | (!!(r & 16) << 6) | (!!(i & 16) << 5) | (!!(b & 16) << 4) |
+		          (w << 3) | (!!(r & 8) << 2) | (!!(i & 8) << 1) | !!(b & 8);
+		*(*c)++ = (uint8_t)opcode;
+	} else {
+		write_rex(c, w, r & 8, i & 8, b & 8, force);
+		write_opcode(c, opcode);
+	}
+}
 static void write_displacement(uint8_t **c, int displacement_form, int32_t displacement) {
 	**c = (uint8_t)displacement;
 	*c += displacement_form == 1;
 	W4(*c, displacement);
 	*c += 4 * (displacement_form == 2);
 }
-static void write_m(uint8_t **c, x64w_Mem m, uint8_t mod, unsigned r7, unsigned i7, unsigned b7) {
+static void write_m_df(uint8_t **c, x64w_Mem m, int df, uint8_t mod, unsigned r7, unsigned i7, unsigned b7) {
 	unsigned s = index_scale_table[m.index_scale];
 
 	if (m.base_scale) {
-		int df = x64w_displacement_form(m);
 		if (m.index_scale) {
 			*(*c)++ = mod | (df << 6) | (r7 << 3) | 0x04;
 			*(*c)++ = s | (i7 << 3) | b7;
@@ -657,6 +1087,23 @@ static void write_m(uint8_t **c, x64w_Mem m, uint8_t mod, unsigned r7, unsigned
 		*c += 4;
 	}
 }
+static void write_m(uint8_t **c, x64w_Mem m, uint8_t mod, unsigned r7, unsigned i7, unsigned b7) {
+	write_m_df(c, m, x64w_displacement_form(m), mod, r7, i7, b7);
+}
+#if X64W_EXT_AVX || X64W_EXT_AVX512 || X64W_EXT_FMA || X64W_EXT_CRYPTO
+// EVEX encoded 8-bit displacement is multiplied by N, the size of memory access
+// that is determined by tuple type (disp8*N). Without a base it's always 32-bit.
+static void write_evex_m(uint8_t **c, x64w_Mem m, unsigned n, unsigned r7, unsigned i7, unsigned b7) {
+	int df = x64w_df_32bit;
+	if (m.displacement == 0 && b7 != 5) {
+		df = x64w_df_no;
+	} else if (m.base_scale && m.displacement % (int32_t)n == 0 && x64w_fits_in_8(m.displacement / (int32_t)n)) {
+		df = x64w_df_8bit;
+		m.displacement /= (int32_t)n;
+	}
+	write_m_df(c, m, df, 0, r7, i7, b7);
+}
+#endif
 static void write_immediate(uint8_t **c, int64_t i, unsigned size) {
 	switch (size) {
 		case 1: **c = (uint8_t)i; break;
@@ -687,6 +1134,26 @@ static void write_immediate(uint8_t **c, int64_t i, unsigned size) {
 #define instr_inline
 #endif
 
+static instr_inline x64w_Result instr(uint8_t **c, uint32_t opcode, uint64_t flags) {
+	unsigned rexw          = !!(flags & REXW);
+	unsigned size_override = !!(flags & OSO);
+	unsigned rep           = !!(flags & REP);
+	unsigned repne         = !!(flags & REPNE);
+
+	**c = 0x66;
+	*c += size_override;
+
+	**c = 0xf3;
+	*c += rep;
+	**c = 0xf2;
+	*c += repne;
+
+	write_rex(c, rexw, 0, 0, 0, 0);
+
+	write_opcode(c, opcode);
+
+	return 0;
+}
 static instr_inline x64w_Result instr_i1(uint8_t **c, int8_t i, uint32_t opcode) {
 	write_opcode(c, opcode);
 	*(*c)++ = i;
@@ -702,9 +1169,11 @@ static instr_inline x64w_Result instr_r(uint8_t **c, uint8_t r, unsigned size, u
 	uint8_t *restore = *c;
 	X64W_VALIDATE_R(r);
 
+	X64W_VALIDATE_REX2(opcode, X64W_REG(r, size));
+
 	mod <<= 3;
 	
-	unsigned rexb = !!(r & 8);
+	unsigned b = X64W_REG(r, size);
 	
 	unsigned rexw          = !!(flags & REXW);
 	unsigned size_override = !!(flags & OSO);
@@ -713,24 +1182,24 @@ static instr_inline x64w_Result instr_r(uint8_t **c, uint8_t r, unsigned size, u
 	**c = 0x66;
 	*c += size_override;
 
-	write_rex(c, rexw, 0, 0, rexb, X64W_GPR8_NEEDS_REX(r));
-
 	if (no_modrm) {
-		*(*c)++ = opcode | (r & 7);
+		write_rex_opcode(c, rexw, 0, 0, b, X64W_GPR8_NEEDS_REX(r), opcode | (r & 7));
 	} else {
-		*(*c)++ = opcode;
+		write_rex_opcode(c, rexw, 0, 0, b, X64W_GPR8_NEEDS_REX(r), opcode);
 		*(*c)++ = 0xc0 | mod | (r & 7);
 	}
 
 	return 0;
 }
-static instr_inline x64w_Result instr_ri(uint8_t **c, uint8_t r, int64_t i, unsigned size, uint32_t opcode, uint8_t mod, uint64_t flags) {
+static instr_inline x64w_Result instr_ri(uint8_t **c, uint8_t r, int64_t i, unsigned size, unsigned imm_size, uint32_t opcode, uint8_t mod, uint64_t flags) {
 	uint8_t *restore = *c;
 	X64W_VALIDATE_R(r);
 
+	X64W_VALIDATE_REX2(opcode, X64W_REG(r, size));
+
 	mod <<= 3;
 	
-	unsigned rexb = !!(r & 8);
+	unsigned b = X64W_REG(r, size);
 	
 	unsigned rexw          = !!(flags & REXW);
 	unsigned size_override = !!(flags & OSO);
@@ -739,42 +1208,44 @@ static instr_inline x64w_Result instr_ri(uint8_t **c, uint8_t r, int64_t i, unsi
 	**c = 0x66;
 	*c += size_override;
 
-	write_rex(c, rexw, 0, 0, rexb, X64W_GPR8_NEEDS_REX(r));
-
 	if (no_modrm) {
-		*(*c)++ = opcode | (r & 7);
+		write_rex_opcode(c, rexw, 0, 0, b, X64W_GPR8_NEEDS_REX(r), opcode | (r & 7));
 	} else {
-		write_opcode(c, opcode);
+		write_rex_opcode(c, rexw, 0, 0, b, X64W_GPR8_NEEDS_REX(r), opcode);
 		*(*c)++ = 0xc0 | mod | (r & 7);
 	}
 	
-	write_immediate(c, i, size);
+	write_immediate(c, i, imm_size);
 
 	return 0;
 }
 static instr_inline x64w_Result instr_m(uint8_t **c, x64w_Mem d, uint32_t opcode, uint8_t mod, uint64_t flags) {
 	uint8_t *restore = *c;
 	X64W_VALIDATE_M(d);
+	X64W_VALIDATE_REX2(opcode, d.base | d.index);
 	
 	mod <<= 3;
 	
 	unsigned rexw          = !!(flags & REXW);
 	unsigned size_override = !!(flags & OSO);
+	unsigned lock          = !!(flags & LOCK);
 	
 	unsigned b7 = d.base & 7;
 	unsigned i7 = d.index & 7;
-	unsigned rexb = d.base >> 3;
-	unsigned rexi = d.index >> 3;
 	
+	**c = 0xf0;
+	*c += lock;
+
+	**c = 0x63 + d.segment;
+	*c += !!d.segment;
+
 	**c = 0x67;
 	*c += d.size_override;
 
 	**c = 0x66;
 	*c += size_override;
 
-	write_rex(c, rexw, 0, rexi, rexb, 0);
-
-	write_opcode(c, opcode);
+	write_rex_opcode(c, rexw, 0, d.index, d.base, 0, opcode);
 
 	write_m(c, d, mod, 0, i7, b7);
 
@@ -783,19 +1254,50 @@ static instr_inline x64w_Result instr_m(uint8_t **c, x64w_Mem d, uint32_t opcode
 static instr_inline x64w_Result instr_rr(uint8_t **c, uint8_t d, uint8_t s, unsigned size, uint32_t opcode, uint64_t flags) {
 	uint8_t *restore = *c;
 	X64W_VALIDATE_RR(d, s);
+	X64W_VALIDATE_REX2(opcode, X64W_REG(d, size) | X64W_REG(s, size));
 	
 	unsigned rexw          = !!(flags & REXW);
 	unsigned size_override = !!(flags & OSO);
+	unsigned rep           = !!(flags & REP);
+	unsigned repne         = !!(flags & REPNE);
+	
+	**c = 0x66;
+	*c += size_override;
+
+	// Mandatory prefix must immediately precede REX
+	**c = 0xf3;
+	*c += rep;
+	**c = 0xf2;
+	*c += repne;
+
+	write_rex_opcode(c, rexw, X64W_REG(d, size), 0, X64W_REG(s, size), X64W_GPR8_NEEDS_REX(d) | X64W_GPR8_NEEDS_REX(s), opcode);
+
+	*(*c)++ = 0xc0 | (s & 7) | ((d & 7) << 3);
+
+	return 0;
+}
+// r16/32/64, r8
+static instr_inline x64w_Result instr_rr8(uint8_t **c, uint8_t d, uint8_t s, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE(d < X64W_GPR_LIMIT, "invalid register");
+	X64W_VALIDATE(s < 0x10 || (0x14 <= s && s < 0x18), "invalid register");
+	X64W_VALIDATE_REX2(opcode, d);
 	
-	unsigned rexb = !!(s & 8);
-	unsigned rexr = !!(d & 8);
+	unsigned rexw          = !!(flags & REXW);
+	unsigned size_override = !!(flags & OSO);
+	unsigned repne         = !!(flags & REPNE);
+
+	X64W_VALIDATE(!(x64w_ah.i <= s && s <= x64w_bh.i) || !(rexw || d >= 8),
+		"ah,ch,dh,bh cannot be used with r8-31 or 64-bit registers");
 	
 	**c = 0x66;
 	*c += size_override;
 
-	write_rex(c, rexw, rexr, 0, rexb, X64W_GPR8_NEEDS_REX(d) | X64W_GPR8_NEEDS_REX(s));
+	// Mandatory prefix must immediately precede REX
+	**c = 0xf2;
+	*c += repne;
 
-	write_opcode(c, opcode);
+	write_rex_opcode(c, rexw, d, 0, s & 15, X64W_GPR8_NEEDS_REX(s), opcode);
 
 	*(*c)++ = 0xc0 | (s & 7) | ((d & 7) << 3);
 
@@ -804,26 +1306,37 @@ static instr_inline x64w_Result instr_rr(uint8_t **c, uint8_t d, uint8_t s, unsi
 static instr_inline x64w_Result instr_rm(uint8_t **c, uint8_t r, x64w_Mem m, unsigned size, uint32_t opcode, uint64_t flags) {
 	uint8_t *restore = *c;
 	X64W_VALIDATE_RM(r, m);
+	X64W_VALIDATE_REX2(opcode, X64W_REG(r, size) | m.base | m.index);
 	
 	unsigned rexw          = !!(flags & REXW);
 	unsigned size_override = !!(flags & OSO);
+	unsigned rep           = !!(flags & REP);
+	unsigned repne         = !!(flags & REPNE);
+	unsigned lock          = !!(flags & LOCK);
 	
 	unsigned r7 = r & 7;
 	unsigned b7 = m.base & 7;
 	unsigned i7 = m.index & 7;
-	unsigned rexb = m.base >> 3;
-	unsigned rexi = m.index >> 3;
-	unsigned rexr = !!(r & 8);
 	
+	**c = 0xf0;
+	*c += lock;
+
+	**c = 0x63 + m.segment;
+	*c += !!m.segment;
+
 	**c = 0x67;
 	*c += m.size_override;
 
 	**c = 0x66;
 	*c += size_override;
 
-	write_rex(c, rexw, rexr, rexi, rexb, X64W_GPR8_NEEDS_REX(r));
-	
-	write_opcode(c, opcode);
+	// Mandatory prefix must immediately precede REX
+	**c = 0xf3;
+	*c += rep;
+	**c = 0xf2;
+	*c += repne;
+
+	write_rex_opcode(c, rexw, X64W_REG(r, size), m.index, m.base, X64W_GPR8_NEEDS_REX(r), opcode);
 	
 	write_m(c, m, 0, r7, i7, b7);
 
@@ -832,26 +1345,30 @@ static instr_inline x64w_Result instr_rm(uint8_t **c, uint8_t r, x64w_Mem m, uns
 static instr_inline x64w_Result instr_mi(uint8_t **c, x64w_Mem m, int64_t i, unsigned size, uint32_t opcode, uint8_t mod, uint64_t flags) {
 	uint8_t *restore = *c;
 	X64W_VALIDATE_M(m);
+	X64W_VALIDATE_REX2(opcode, m.base | m.index);
 	
 	mod <<= 3;
 	
 	unsigned rexw          = !!(flags & REXW);
 	unsigned size_override = !!(flags & OSO);
+	unsigned lock          = !!(flags & LOCK);
 	
 	unsigned b7 = m.base & 7;
 	unsigned i7 = m.index & 7;
-	unsigned rexb = m.base >> 3;
-	unsigned rexi = m.index >> 3;
 	
+	**c = 0xf0;
+	*c += lock;
+
+	**c = 0x63 + m.segment;
+	*c += !!m.segment;
+
 	**c = 0x67;
 	*c += m.size_override;
 
 	**c = 0x66;
 	*c += size_override;
 
-	write_rex(c, rexw, 0, rexi, rexb, 0);
-
-	write_opcode(c, opcode);
+	write_rex_opcode(c, rexw, 0, m.index, m.base, 0, opcode);
 	
 	write_m(c, m, mod, 0, i7, b7);
 
@@ -859,147 +1376,425 @@ static instr_inline x64w_Result instr_mi(uint8_t **c, x64w_Mem m, int64_t i, uns
 
 	return 0;
 }
-static instr_inline x64w_Result instr_xxx(uint8_t **c, uint8_t d, uint8_t a, uint8_t b, unsigned size, uint32_t opcode) {
+// r, r/m, imm. `size` is the size of registers, `imm_size` - of the immediate.
+static instr_inline x64w_Result instr_rri(uint8_t **c, uint8_t d, uint8_t s, int64_t i, unsigned size, unsigned imm_size, uint32_t opcode, uint64_t flags) {
+	x64w_Result result = instr_rr(c, d, s, size, opcode, flags);
+	if (result)
+		return result;
+
+	write_immediate(c, i, imm_size);
+
+	return 0;
+}
+static instr_inline x64w_Result instr_rmi(uint8_t **c, uint8_t r, x64w_Mem m, int64_t i, unsigned size, unsigned imm_size, uint32_t opcode, uint64_t flags) {
+	x64w_Result result = instr_rm(c, r, m, size, opcode, flags);
+	if (result)
+		return result;
+
+	write_immediate(c, i, imm_size);
+
+	return 0;
+}
+#if X64W_EXT_BMI || X64W_EXT_CRYPTO
+// VEX only instruction, with general purpose registers or xmm0-15:
+//     r - ModRM.reg, register or opcode extension
+//     v - VEX.vvvv, 0 if not used
+//     b - ModRM.rm
+// Map is a part of the opcode, pp comes from OSO/REP/REPNE.
+static instr_inline x64w_Result instr_vrr(uint8_t **c, uint8_t r, uint8_t v, uint8_t b, unsigned size, uint32_t opcode, uint64_t flags) {
 	uint8_t *restore = *c;
-	X64W_VALIDATE_X(d);
-	X64W_VALIDATE_X(a);
-	X64W_VALIDATE_X(b);
-	
-	unsigned rexr = !!(d & 8);
+	X64W_VALIDATE_R(r);
+	X64W_VALIDATE_R(v);
+	X64W_VALIDATE_R(b);
+	X64W_VALIDATE_LOW(r | v | b);
+
+	unsigned rexw = !!(flags & REXW);
+	unsigned rexr = !!(r & 8);
 	unsigned rexb = !!(b & 8);
-	unsigned rexrh = !!(d & 16);
+
+	write_vex(c, rexr, 0, rexb, vex_map(opcode), rexw, v, 0, vex_pp(flags));
+
+	write_opcode(c, opcode & 0xff);
+
+	*(*c)++ = 0xc0 | (b & 7) | ((r & 7) << 3);
+
+	return 0;
+}
+static instr_inline x64w_Result instr_vrm(uint8_t **c, uint8_t r, uint8_t v, x64w_Mem m, unsigned size, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_R(r);
+	X64W_VALIDATE_R(v);
+	X64W_VALIDATE_M(m);
+	X64W_VALIDATE_LOW(r | v | m.base | m.index);
+
+	unsigned rexw = !!(flags & REXW);
+	unsigned r7 = r & 7;
+	unsigned b7 = m.base & 7;
+	unsigned i7 = m.index & 7;
+	unsigned rexb = m.base >> 3;
+	unsigned rexi = m.index >> 3;
+	unsigned rexr = !!(r & 8);
+
+	**c = 0x63 + m.segment;
+	*c += !!m.segment;
+
+	**c = 0x67;
+	*c += m.size_override;
+
+	write_vex(c, rexr, rexi, rexb, vex_map(opcode), rexw, v, 0, vex_pp(flags));
+
+	write_opcode(c, opcode & 0xff);
+
+	write_m(c, m, 0, r7, i7, b7);
+
+	return 0;
+}
+static instr_inline x64w_Result instr_vrri(uint8_t **c, uint8_t r, uint8_t b, uint8_t i, unsigned size, uint32_t opcode, uint64_t flags) {
+	x64w_Result result = instr_vrr(c, r, 0, b, size, opcode, flags);
+	if (result)
+		return result;
+
+	*(*c)++ = i;
+
+	return 0;
+}
+static instr_inline x64w_Result instr_vrmi(uint8_t **c, uint8_t r, x64w_Mem m, uint8_t i, unsigned size, uint32_t opcode, uint64_t flags) {
+	x64w_Result result = instr_vrm(c, r, 0, m, size, opcode, flags);
+	if (result)
+		return result;
+
+	*(*c)++ = i;
+
+	return 0;
+}
+#endif
+#if X64W_EXT_AVX || X64W_EXT_AVX512 || X64W_EXT_FMA || X64W_EXT_CRYPTO
+// VEX or EVEX encoded instruction with vector registers:
+//     r - ModRM.reg, register or opcode extension
+//     v - VEX.vvvv, 0 if not used
+//     b - ModRM.rm
+//     k - opmask register, 0 if not masked
+// Map is a part of the opcode, pp comes from OSO/REP/REPNE, W from REXW, L from size.
+// EVEX is used for zmm, registers 16-31, masking and broadcast, otherwise the shorter VEX.
+static instr_inline x64w_Result instr_xxxk(uint8_t **c, uint8_t r, uint8_t v, uint8_t b, uint8_t k, unsigned size, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(r);
+	X64W_VALIDATE_X(v);
+	X64W_VALIDATE_X(b);
 	
-	if (size == 64) {
-		write_evex(c, rexr, 0, rexb, rexrh, vex_m_0f, 1, a & 15, vex_p_66, 0, 2, 0, !!(a & 16), 0);
+	unsigned m = vex_map(opcode);
+	unsigned p = vex_pp(flags);
+	unsigned w = !!(flags & REXW);
+	unsigned z = !!(flags & ZEROING);
+
+	X64W_VALIDATE(k || !z, "zeroing requires a mask");
+
+	if (size == 64 || ((r | v | b) & 16) || k) {
+		write_evex(c, r & 8, b & 16, b & 8, r & 16, m, w | !!(flags & EVEXW), v & 15, p, z, size >> 5, 0, v & 16, k);
 	} else {
-		write_vex(c, rexr, 0, rexb, vex_m_0f, 0, a, size == 32, vex_p_66);
+		write_vex(c, r & 8, 0, b & 8, m, w, v, size == 32, p);
 	}
 
-	write_opcode(c, 0x58);
+	write_opcode(c, opcode & 0xff);
 
-	*(*c)++ = 0xc0 | (b & 7) | ((d & 7) << 3);
+	*(*c)++ = 0xc0 | (b & 7) | ((r & 7) << 3);
 
 	return 0;
 }
-static instr_inline x64w_Result instr_xxm(uint8_t **c, uint8_t d, uint8_t a, x64w_Mem b, unsigned size, uint32_t opcode) {
+static instr_inline x64w_Result instr_xxmk(uint8_t **c, uint8_t r, uint8_t v, x64w_Mem b, uint8_t k, unsigned size, uint32_t opcode, uint64_t flags) {
 	uint8_t *restore = *c;
-	X64W_VALIDATE_X(d);
-	X64W_VALIDATE_X(a);
+	X64W_VALIDATE_X(r);
+	X64W_VALIDATE_X(v);
 	X64W_VALIDATE_M(b);
+	X64W_VALIDATE_LOW(b.base | b.index);
+
+	unsigned m = vex_map(opcode);
+	unsigned p = vex_pp(flags);
+	unsigned w = !!(flags & REXW);
+	unsigned z = !!(flags & ZEROING);
+	unsigned bcst = !!(flags & BCST);
+	unsigned element_size = (w | !!(flags & EVEXW)) ? 8 : 4;
+
+	X64W_VALIDATE(k || !z, "zeroing requires a mask");
 
-	unsigned r7 = d & 7;
+	unsigned r7 = r & 7;
 	unsigned b7 = b.base & 7;
 	unsigned i7 = b.index & 7;
 	unsigned rexb = b.base >> 3;
 	unsigned rexi = b.index >> 3;
-	unsigned rexr = !!(d & 8);
-	unsigned rexrh = !!(d & 16);
+	unsigned rexr = !!(r & 8);
 	
+	**c = 0x63 + b.segment;
+	*c += !!b.segment;
+
 	**c = 0x67;
 	*c += b.size_override;
 
-	if (size == 64) {
-		write_evex(c, rexr, rexi, rexb, rexrh, vex_m_0f, 1, a & 15, vex_p_66, 0, 2, 0, !!(a & 16), 0);
+	if (size == 64 || ((r | v) & 16) || k || bcst) {
+		write_evex(c, rexr, rexi, rexb, r & 16, m, w | !!(flags & EVEXW), v & 15, p, z, size >> 5, bcst, v & 16, k);
+		write_opcode(c, opcode & 0xff);
+		write_evex_m(c, b, (bcst || (flags & T1S)) ? element_size : size, r7, i7, b7);
 	} else {
-		write_vex(c, rexr, rexi, rexb, vex_m_0f, 0, a, size == 32, vex_p_66);
+		write_vex(c, rexr, rexi, rexb, m, w, v, size == 32, p);
+		write_opcode(c, opcode & 0xff);
+		write_m(c, b, 0, r7, i7, b7);
 	}
-
-	write_opcode(c, 0x58);
-	
-	if (size == 64)
-		return "not implemented";
-
-	// for zmm, mod has to be something different
-
-  // 62 F1 FD 48 58 04 25 00 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [0000000000000000h]
-  // 62 F1 FD 48 58 00                 vaddpd zmm0,zmm0,zmmword ptr [rax]
-  // 62 F1 FD 48 58 04 24              vaddpd zmm0,zmm0,zmmword ptr [rsp]
-  // 62 F1 FD 48 58 45 00              vaddpd zmm0,zmm0,zmmword ptr [rbp]
-  // 62 D1 FD 48 58 00                 vaddpd zmm0,zmm0,zmmword ptr [r8]
-  // 62 F1 FD 48 58 80 01 00 00 00     vaddpd zmm0,zmm0,zmmword ptr [rax+0000000000000001h]
-  // 62 F1 FD 48 58 84 24 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rsp+0000000000000001h]
-  // 62 F1 FD 48 58 85 01 00 00 00     vaddpd zmm0,zmm0,zmmword ptr [rbp+0000000000000001h]
-  // 62 D1 FD 48 58 80 01 00 00 00     vaddpd zmm0,zmm0,zmmword ptr [r8+0000000000000001h]
-  // 62 F1 FD 48 58 04 C0              vaddpd zmm0,zmm0,zmmword ptr [rax+rax*8]
-  // 62 F1 FD 48 58 04 C4              vaddpd zmm0,zmm0,zmmword ptr [rsp+rax*8]
-  // 62 F1 FD 48 58 44 C5 00           vaddpd zmm0,zmm0,zmmword ptr [rbp+rax*8]
-  // 62 D1 FD 48 58 04 C0              vaddpd zmm0,zmm0,zmmword ptr [r8+rax*8]
-  // 62 F1 FD 48 58 84 C0 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax+rax*8+0000000000000001h]
-  // 62 F1 FD 48 58 84 C4 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rsp+rax*8+0000000000000001h]
-  // 62 F1 FD 48 58 84 C5 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rbp+rax*8+0000000000000001h]
-  // 62 D1 FD 48 58 84 C0 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [r8+rax*8+0000000000000001h]
-  // 62 F1 FD 48 58 04 C5 00 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000000h]
-  // 62 F1 FD 48 58 04 C5 00 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000000h]
-  // 62 F1 FD 48 58 04 C5 00 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000000h]
-  // 62 F1 FD 48 58 04 C5 00 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000000h]
-  // 62 F1 FD 48 58 04 C5 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000001h]
-  // 62 F1 FD 48 58 04 C5 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000001h]
-  // 62 F1 FD 48 58 04 C5 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000001h]
-  // 62 F1 FD 48 58 04 C5 01 00 00 00  vaddpd zmm0,zmm0,zmmword ptr [rax*8+0000000000000001h]
-                    
-
-	write_m(c, b, 0, r7, i7, b7);
 	
 	return 0;
 }
+static instr_inline x64w_Result instr_xxx(uint8_t **c, uint8_t r, uint8_t v, uint8_t b, unsigned size, uint32_t opcode, uint64_t flags) {
+	return instr_xxxk(c, r, v, b, 0, size, opcode, flags);
+}
+static instr_inline x64w_Result instr_xxm(uint8_t **c, uint8_t r, uint8_t v, x64w_Mem b, unsigned size, uint32_t opcode, uint64_t flags) {
+	return instr_xxmk(c, r, v, b, 0, size, opcode, flags);
+}
+#endif
+#if X64W_EXT_AVX || X64W_EXT_AVX512 || X64W_EXT_CRYPTO
+static instr_inline x64w_Result instr_xxxi(uint8_t **c, uint8_t r, uint8_t v, uint8_t b, uint8_t i, unsigned size, uint32_t opcode, uint64_t flags) {
+	x64w_Result result = instr_xxx(c, r, v, b, size, opcode, flags);
+	if (result)
+		return result;
+
+	*(*c)++ = i;
+
+	return 0;
+}
+static instr_inline x64w_Result instr_xxmi(uint8_t **c, uint8_t r, uint8_t v, x64w_Mem b, uint8_t i, unsigned size, uint32_t opcode, uint64_t flags) {
+	x64w_Result result = instr_xxm(c, r, v, b, size, opcode, flags);
+	if (result)
+		return result;
+
+	*(*c)++ = i;
+
+	return 0;
+}
+#endif
+#if X64W_EXT_AVX || X64W_EXT_AVX512
+// Gathers and scatters. `m` is VSIB memory operand, its index is a vector register.
+// `size` is the larger of data and index register sizes, it determines L.
+// Elements are 8 bytes if REXW is set, 4 otherwise, that's N of disp8*N.
+static void write_vsib(uint8_t **c, uint8_t r, x64w_Vsib m, uint8_t v, uint8_t k, unsigned size, uint32_t opcode, uint64_t flags) {
+	x64w_Mem b = {
+		.base = m.base,
+		.index = (uint8_t)(m.index & 15),
+		.base_scale = m.base_scale,
+		.index_scale = m.index_scale,
+		.size_override = m.size_override,
+		.segment = 0,
+		.displacement = m.displacement,
+	};
+	unsigned w = !!(flags & REXW);
+
+	**c = 0x67;
+	*c += m.size_override;
+
+	if (k) {
+		write_evex(c, r & 8, m.index & 8, m.base & 8, r & 16, vex_map(opcode), w, 0, vex_pp(flags), 0, size >> 5, 0, m.index & 16, k);
+		write_opcode(c, opcode & 0xff);
+		write_evex_m(c, b, w ? 8 : 4, r & 7, m.index & 7, m.base & 7);
+	} else {
+		write_vex(c, r & 8, m.index & 8, m.base & 8, vex_map(opcode), w, v, size == 32, vex_pp(flags));
+		write_opcode(c, opcode & 0xff);
+		write_m(c, b, 0, r & 7, m.index & 7, m.base & 7);
+	}
+}
+#endif
+#if X64W_EXT_AVX
+// VEX encoded gather, `v` is the vector mask. Elements are loaded where its sign bit is set.
+static instr_inline x64w_Result instr_gather(uint8_t **c, uint8_t r, x64w_Vsib m, uint8_t v, unsigned size, unsigned index_size, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE(r < 0x10, "invalid register");
+	X64W_VALIDATE(v < 0x10, "invalid register");
+	X64W_VALIDATE(m.index < 0x10, "invalid register");
+	X64W_VALIDATE_V(m);
+	X64W_VALIDATE_LOW(m.base);
+	X64W_VALIDATE(16u << m.index_size == index_size, "index register has wrong size for this form");
+	X64W_VALIDATE(r != v && r != m.index && v != m.index, "destination, index and mask registers must be different");
+
+	write_vsib(c, r, m, v, 0, size, opcode, flags);
+	return 0;
+}
+#endif
+#if X64W_EXT_AVX512
+// EVEX encoded gather, `k` is the opmask. Elements are loaded where its bit is set.
+static instr_inline x64w_Result instr_gatherk(uint8_t **c, uint8_t r, uint8_t k, x64w_Vsib m, unsigned size, unsigned index_size, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(r);
+	X64W_VALIDATE_V(m);
+	X64W_VALIDATE_LOW(m.base);
+	X64W_VALIDATE(16u << m.index_size == index_size, "index register has wrong size for this form");
+	X64W_VALIDATE(k, "gathers require a mask other than k0");
+	X64W_VALIDATE(r != m.index, "destination and index registers must be different");
+
+	write_vsib(c, r, m, 0, k, size, opcode, flags);
+	return 0;
+}
+// EVEX encoded scatter, `k` is the opmask. Elements are stored where its bit is set.
+static instr_inline x64w_Result instr_scatterk(uint8_t **c, x64w_Vsib m, uint8_t k, uint8_t r, unsigned size, unsigned index_size, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(r);
+	X64W_VALIDATE_V(m);
+	X64W_VALIDATE_LOW(m.base);
+	X64W_VALIDATE(16u << m.index_size == index_size, "index register has wrong size for this form");
+	X64W_VALIDATE(k, "scatters require a mask other than k0");
+
+	write_vsib(c, r, m, 0, k, size, opcode, flags);
+	return 0;
+}
+#endif
+#if X64W_EXT_APX
+// New data destination forms, d receives the result of the operation on the other operands.
+static instr_inline x64w_Result instr_ndd_rr(uint8_t **c, uint8_t d, uint8_t r, uint8_t b, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(d);
+	X64W_VALIDATE_X(r);
+	X64W_VALIDATE_X(b);
+
+	write_evex_map4(c, r, 0, b, d, !!(flags & REXW), !!(flags & OSO), 1);
+
+	*(*c)++ = opcode;
+	*(*c)++ = 0xc0 | ((r & 7) << 3) | (b & 7);
+
+	return 0;
+}
+static instr_inline x64w_Result instr_ndd_rm(uint8_t **c, uint8_t d, uint8_t r, x64w_Mem m, uint32_t opcode, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(d);
+	X64W_VALIDATE_X(r);
+	X64W_VALIDATE_M(m);
+
+	**c = 0x63 + m.segment;
+	*c += !!m.segment;
+
+	**c = 0x67;
+	*c += m.size_override;
+
+	write_evex_map4(c, r, m.index, m.base, d, !!(flags & REXW), !!(flags & OSO), 1);
+
+	*(*c)++ = opcode;
+	write_m(c, m, 0, r & 7, m.index & 7, m.base & 7);
+
+	return 0;
+}
+static instr_inline x64w_Result instr_ndd_ri(uint8_t **c, uint8_t d, uint8_t b, int64_t i, unsigned size, uint32_t opcode, uint8_t mod, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(d);
+	X64W_VALIDATE_X(b);
+
+	write_evex_map4(c, 0, 0, b, d, !!(flags & REXW), !!(flags & OSO), 1);
+
+	*(*c)++ = opcode;
+	*(*c)++ = 0xc0 | (mod << 3) | (b & 7);
+
+	write_immediate(c, i, size);
+
+	return 0;
+}
+static instr_inline x64w_Result instr_ndd_mi(uint8_t **c, uint8_t d, x64w_Mem m, int64_t i, unsigned size, uint32_t opcode, uint8_t mod, uint64_t flags) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE_X(d);
+	X64W_VALIDATE_M(m);
+
+	**c = 0x63 + m.segment;
+	*c += !!m.segment;
+
+	**c = 0x67;
+	*c += m.size_override;
+
+	write_evex_map4(c, 0, m.index, m.base, d, !!(flags & REXW), !!(flags & OSO), 1);
+
+	*(*c)++ = opcode;
+	write_m(c, m, mod << 3, 0, m.index & 7, m.base & 7);
+
+	write_immediate(c, i, size);
+
+	return 0;
+}
+#endif
 
 
 #undef no_inline
 #undef force_inline
 #undef instr_inline
 
-x64w_Result x64w_push_i8 (uint8_t **c, int8_t   i) { return instr_i1(c, i, 0x6a); }
-x64w_Result x64w_push_i32(uint8_t **c, int32_t  i) { return instr_i4(c, i, 0x68); }
-x64w_Result x64w_push_r16(uint8_t **c, x64w_Gpr16 s) { return instr_r(c, s.i, 2, 0x50, 0, NO_MODRM | OSO); }
-x64w_Result x64w_push_r64(uint8_t **c, x64w_Gpr64 s) { return instr_r(c, s.i, 8, 0x50, 0, NO_MODRM); }
-x64w_Result x64w_push_m16(uint8_t **c, x64w_Mem d) { return instr_m(c, d, 0xff, 6, OSO); }
-x64w_Result x64w_push_m64(uint8_t **c, x64w_Mem d) { return instr_m(c, d, 0xff, 6, 0); }
-
-x64w_Result x64w_pop_r16(uint8_t **c, x64w_Gpr16 s) { return instr_r(c, s.i, 2, 0x58, 0, NO_MODRM | OSO); }
-x64w_Result x64w_pop_r64(uint8_t **c, x64w_Gpr64 s) { return instr_r(c, s.i, 8, 0x58, 0, NO_MODRM); }
-x64w_Result x64w_pop_m16(uint8_t **c, x64w_Mem d) { return instr_m(c, d, 0x8f, 0, OSO); }
-x64w_Result x64w_pop_m64(uint8_t **c, x64w_Mem d) { return instr_m(c, d, 0x8f, 0, 0); }
-
-x64w_Result x64w_mov_ri8 (uint8_t **c, x64w_Gpr8  r, int8_t   i) { return instr_ri(c, r.i, i, 1, 0xb0, 0, NO_MODRM); }
-x64w_Result x64w_mov_ri16(uint8_t **c, x64w_Gpr16 r, int16_t  i) { return instr_ri(c, r.i, i, 2, 0xb8, 0, NO_MODRM|OSO); }
-x64w_Result x64w_mov_ri32(uint8_t **c, x64w_Gpr32 r, int32_t  i) { return instr_ri(c, r.i, i, 4, 0xb8, 0, NO_MODRM); }
-x64w_Result x64w_mov_ri64(uint8_t **c, x64w_Gpr64 r, int64_t  i) { return instr_ri(c, r.i, i, 8, 0xb8, 0, NO_MODRM|REXW); }
-x64w_Result x64w_mov_rr8 (uint8_t **c, x64w_Gpr8  d, x64w_Gpr8  s) { return instr_rr(c, d.i, s.i, 1, 0x8a, 0); }
-x64w_Result x64w_mov_rr16(uint8_t **c, x64w_Gpr16 d, x64w_Gpr16 s) { return instr_rr(c, d.i, s.i, 2, 0x8b, OSO); }
-x64w_Result x64w_mov_rr32(uint8_t **c, x64w_Gpr32 d, x64w_Gpr32 s) { return instr_rr(c, d.i, s.i, 4, 0x8b, 0); }
-x64w_Result x64w_mov_rr64(uint8_t **c, x64w_Gpr64 d, x64w_Gpr64 s) { return instr_rr(c, d.i, s.i, 8, 0x8b, REXW); }
-x64w_Result x64w_mov_rm8 (uint8_t **c, x64w_Gpr8  d, x64w_Mem s) { return instr_rm(c, d.i, s, 1, 0x8a, 0); }
-x64w_Result x64w_mov_rm16(uint8_t **c, x64w_Gpr16 d, x64w_Mem s) { return instr_rm(c, d.i, s, 2, 0x8b, OSO); }
-x64w_Result x64w_mov_rm32(uint8_t **c, x64w_Gpr32 d, x64w_Mem s) { return instr_rm(c, d.i, s, 4, 0x8b, 0); }
-x64w_Result x64w_mov_rm64(uint8_t **c, x64w_Gpr64 d, x64w_Mem s) { return instr_rm(c, d.i, s, 8, 0x8b, REXW); }
-x64w_Result x64w_mov_mr8 (uint8_t **c, x64w_Mem d, x64w_Gpr8  s) { return instr_rm(c, s.i, d, 1, 0x88, 0); }
-x64w_Result x64w_mov_mr16(uint8_t **c, x64w_Mem d, x64w_Gpr16 s) { return instr_rm(c, s.i, d, 2, 0x89, OSO); }
-x64w_Result x64w_mov_mr32(uint8_t **c, x64w_Mem d, x64w_Gpr32 s) { return instr_rm(c, s.i, d, 4, 0x89, 0); }
-x64w_Result x64w_mov_mr64(uint8_t **c, x64w_Mem d, x64w_Gpr64 s) { return instr_rm(c, s.i, d, 8, 0x89, REXW); }
-x64w_Result x64w_mov_mi8 (uint8_t **c, x64w_Mem m, int8_t  i) { return instr_mi(c, m, i, 1, 0xc6, 0, 0); }
-x64w_Result x64w_mov_mi16(uint8_t **c, x64w_Mem m, int16_t i) { return instr_mi(c, m, i, 2, 0xc7, 0, OSO); }
-x64w_Result x64w_mov_mi32(uint8_t **c, x64w_Mem m, int32_t i) { return instr_mi(c, m, i, 4, 0xc7, 0, 0); }
-x64w_Result x64w_mov_m64i32(uint8_t **c, x64w_Mem m, int32_t i) { return instr_mi(c, m, i, 4, 0xc7, 0, REXW); }
-
-x64w_Result x64w_adcx_rr32(uint8_t **c, x64w_Gpr32 d, x64w_Gpr32 s) { return instr_rr(c, d.i, s.i, 4, 0x0f38f6, OSO); }
-x64w_Result x64w_adcx_rr64(uint8_t **c, x64w_Gpr64 d, x64w_Gpr64 s) { return instr_rr(c, d.i, s.i, 8, 0x0f38f6, OSO | REXW); }
-
-x64w_Result x64w_addpd_xx(uint8_t **c, x64w_Xmm d, x64w_Xmm s) { return instr_rr(c, d.i, s.i, 16, 0x0f58, OSO); }
-x64w_Result x64w_addpd_xm(uint8_t **c, x64w_Xmm d, x64w_Mem s) { return instr_rm(c, d.i, s, 16, 0x0f58, OSO); }
-
-x64w_Result x64w_vaddpd_xxx(uint8_t **c, x64w_Xmm d, x64w_Xmm a, x64w_Xmm b) { return instr_xxx(c, d.i, a.i, b.i, 16, 0x58); }
-x64w_Result x64w_vaddpd_xxm(uint8_t **c, x64w_Xmm d, x64w_Xmm a, x64w_Mem b) { return instr_xxm(c, d.i, a.i, b,   16, 0x58); }
-x64w_Result x64w_vaddpd_yyy(uint8_t **c, x64w_Ymm d, x64w_Ymm a, x64w_Ymm b) { return instr_xxx(c, d.i, a.i, b.i, 32, 0x58); }
-x64w_Result x64w_vaddpd_yym(uint8_t **c, x64w_Ymm d, x64w_Ymm a, x64w_Mem b) { return instr_xxm(c, d.i, a.i, b,   32, 0x58); }
-x64w_Result x64w_vaddpd_zzz(uint8_t **c, x64w_Zmm d, x64w_Zmm a, x64w_Zmm b) { return instr_xxx(c, d.i, a.i, b.i, 64, 0x58); }
-x64w_Result x64w_vaddpd_zzm(uint8_t **c, x64w_Zmm d, x64w_Zmm a, x64w_Mem b) { return instr_xxm(c, d.i, a.i, b,   64, 0x58); }
-
 INSERT_FUNCTION_DEFINITIONS
 
+#if X64W_FORMS
+
+typedef x64w_Result (*x64w_Encoder)(uint8_t **c, x64w_Operand const *o);
+
+INSERT_ENCODERS
+
+x64w_Result x64w_encode(uint8_t **c, x64w_Form form, x64w_Operand const *operands) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE((unsigned)form < x64w_form_count, "invalid instruction form");
+	X64W_VALIDATE(x64w_encoders[form], "instruction form is not enabled");
+	return x64w_encoders[form](c, operands);
+}
+
+INSERT_FORM_INFOS
+
+x64w_FormInfo const *x64w_form_info(x64w_Form form) {
+	if ((unsigned)form >= x64w_form_count)
+		return 0;
+	return &x64w_form_infos[form];
+}
+
+#endif // X64W_FORMS
+
+x64w_Result x64w_nop(uint8_t **c, unsigned n) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE(n <= X64W_MAX_INSTRUCTION_SIZE, "nop can't be longer than 15 bytes");
+
+	// Recommended by Intel optimization manual
+	static uint8_t const nops[10][9] = {
+		{0},
+		{0x90},
+		{0x66, 0x90},
+		{0x0f, 0x1f, 0x00},
+		{0x0f, 0x1f, 0x40, 0x00},
+		{0x0f, 0x1f, 0x44, 0x00, 0x00},
+		{0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00},
+		{0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00},
+		{0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+		{0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+	};
+
+	unsigned base = n < 9 ? n : 9;
+	for (unsigned i = base; i < n; ++i)
+		*(*c)++ = 0x66;
+	for (unsigned i = 0; i < base; ++i)
+		*(*c)++ = nops[base][i];
+
+	return 0;
+}
+
+x64w_Result x64w_align(uint8_t **c, unsigned boundary) {
+	uint8_t *restore = *c;
+	X64W_VALIDATE(boundary && !(boundary & (boundary - 1)), "boundary must be a power of two");
+
+	// Many prefixes slow down decoding on some cores, so long padding is split into several nops.
+	unsigned padding = (unsigned)(-(uintptr_t)*c & (boundary - 1));
+	while (padding) {
+		unsigned n = padding < 11 ? padding : 11;
+		x64w_nop(c, n);
+		padding -= n;
+	}
+
+	return 0;
+}
+
 #undef REXW
 #undef OSO
 #undef ASO
 #undef NO_MODRM
+#undef REP
+#undef REPNE
+#undef EVEXW
+#undef ZEROING
+#undef BCST
+#undef T1S
+#undef LOCK
 
 #undef x64w_fits_in_8
 #undef x64w_fits_in_16
@@ -1011,7 +1806,13 @@ INSERT_FUNCTION_DEFINITIONS
 #undef X64W_VALIDATE_R
 #undef X64W_VALIDATE_RR
 #undef X64W_VALIDATE_M
+#undef X64W_VALIDATE_V
 #undef X64W_VALIDATE_RM
+#undef X64W_VALIDATE_CC
+#undef X64W_VALIDATE_K
+#undef X64W_VALIDATE_LOW
+#undef X64W_VALIDATE_REX2
+#undef X64W_REG
 
 #undef vex_p_none
 #undef vex_p_66
@@ -1036,7 +1837,18 @@ inline constexpr bool operator==(x64w_Gpr64 a, x64w_Gpr64 b) { return a.i == b.i
 inline constexpr bool operator==(x64w_Xmm a, x64w_Xmm b) { return a.i == b.i; }
 inline constexpr bool operator==(x64w_Ymm a, x64w_Ymm b) { return a.i == b.i; }
 inline constexpr bool operator==(x64w_Zmm a, x64w_Zmm b) { return a.i == b.i; }
+inline constexpr bool operator==(x64w_Kreg a, x64w_Kreg b) { return a.i == b.i; }
 inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
+	if (a.size_override != b.size_override) return false;
+	if (a.segment != b.segment) return false;
+	if (a.base_scale != b.base_scale) return false;
+	if (a.index_scale != b.index_scale) return false;
+	if (a.base != b.base) return false;
+	if (a.index != b.index) return false;
+	if (a.displacement != b.displacement) return false;
+	return true;
+}
+inline constexpr bool operator==(x64w_Vsib a, x64w_Vsib b) {
 	if (a.size_override != b.size_override) return false;
 	if (a.base_scale != b.base_scale) return false;
 	if (a.index_scale != b.index_scale) return false;
@@ -1061,6 +1873,8 @@ inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
 #define Xmm x64w_Xmm
 #define Ymm x64w_Ymm
 #define Zmm x64w_Zmm
+#define Kreg x64w_Kreg
+#define Cond x64w_Cond
 #define al   x64w_al
 #define cl   x64w_cl
 #define dl   x64w_dl
@@ -1097,6 +1911,22 @@ inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
 #define r13w x64w_r13w
 #define r14w x64w_r14w
 #define r15w x64w_r15w
+#define r16w x64w_r16w
+#define r17w x64w_r17w
+#define r18w x64w_r18w
+#define r19w x64w_r19w
+#define r20w x64w_r20w
+#define r21w x64w_r21w
+#define r22w x64w_r22w
+#define r23w x64w_r23w
+#define r24w x64w_r24w
+#define r25w x64w_r25w
+#define r26w x64w_r26w
+#define r27w x64w_r27w
+#define r28w x64w_r28w
+#define r29w x64w_r29w
+#define r30w x64w_r30w
+#define r31w x64w_r31w
 #define eax  x64w_eax
 #define ecx  x64w_ecx
 #define edx  x64w_edx
@@ -1113,6 +1943,22 @@ inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
 #define r13d x64w_r13d
 #define r14d x64w_r14d
 #define r15d x64w_r15d
+#define r16d x64w_r16d
+#define r17d x64w_r17d
+#define r18d x64w_r18d
+#define r19d x64w_r19d
+#define r20d x64w_r20d
+#define r21d x64w_r21d
+#define r22d x64w_r22d
+#define r23d x64w_r23d
+#define r24d x64w_r24d
+#define r25d x64w_r25d
+#define r26d x64w_r26d
+#define r27d x64w_r27d
+#define r28d x64w_r28d
+#define r29d x64w_r29d
+#define r30d x64w_r30d
+#define r31d x64w_r31d
 #define rax  x64w_rax
 #define rcx  x64w_rcx
 #define rdx  x64w_rdx
@@ -1129,6 +1975,22 @@ inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
 #define r13  x64w_r13
 #define r14  x64w_r14
 #define r15  x64w_r15
+#define r16  x64w_r16
+#define r17  x64w_r17
+#define r18  x64w_r18
+#define r19  x64w_r19
+#define r20  x64w_r20
+#define r21  x64w_r21
+#define r22  x64w_r22
+#define r23  x64w_r23
+#define r24  x64w_r24
+#define r25  x64w_r25
+#define r26  x64w_r26
+#define r27  x64w_r27
+#define r28  x64w_r28
+#define r29  x64w_r29
+#define r30  x64w_r30
+#define r31  x64w_r31
 #define xmm0 x64w_xmm0
 #define xmm1 x64w_xmm1
 #define xmm2 x64w_xmm2
@@ -1225,6 +2087,42 @@ inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
 #define zmm29 x64w_zmm29
 #define zmm30 x64w_zmm30
 #define zmm31 x64w_zmm31
+#define k0 x64w_k0
+#define k1 x64w_k1
+#define k2 x64w_k2
+#define k3 x64w_k3
+#define k4 x64w_k4
+#define k5 x64w_k5
+#define k6 x64w_k6
+#define k7 x64w_k7
+#define cond_o x64w_cond_o
+#define cond_no x64w_cond_no
+#define cond_b x64w_cond_b
+#define cond_ae x64w_cond_ae
+#define cond_e x64w_cond_e
+#define cond_ne x64w_cond_ne
+#define cond_be x64w_cond_be
+#define cond_a x64w_cond_a
+#define cond_s x64w_cond_s
+#define cond_ns x64w_cond_ns
+#define cond_p x64w_cond_p
+#define cond_np x64w_cond_np
+#define cond_l x64w_cond_l
+#define cond_ge x64w_cond_ge
+#define cond_le x64w_cond_le
+#define cond_g x64w_cond_g
+#define cond_c x64w_cond_c
+#define cond_nc x64w_cond_nc
+#define cond_z x64w_cond_z
+#define cond_nz x64w_cond_nz
+#define cond_na x64w_cond_na
+#define cond_nbe x64w_cond_nbe
+#define cond_pe x64w_cond_pe
+#define cond_po x64w_cond_po
+#define cond_nge x64w_cond_nge
+#define cond_nl x64w_cond_nl
+#define cond_ng x64w_cond_ng
+#define cond_nle x64w_cond_nle
 #define Mem x64w_Mem
 #define mem32_b x64w_mem32_b
 #define mem32_i x64w_mem32_i
@@ -1240,48 +2138,30 @@ inline constexpr bool operator==(x64w_Mem a, x64w_Mem b) {
 #define mem64_bd x64w_mem64_bd
 #define mem64_id x64w_mem64_id
 #define mem64_bid x64w_mem64_bid
+#define seg_none x64w_seg_none
+#define seg_fs x64w_seg_fs
+#define seg_gs x64w_seg_gs
+#define mem_fs x64w_mem_fs
+#define mem_gs x64w_mem_gs
+#define Vsib x64w_Vsib
+#define vsib32_bi x64w_vsib32_bi
+#define vsib32_id x64w_vsib32_id
+#define vsib32_bid x64w_vsib32_bid
+#define vsib64_bi x64w_vsib64_bi
+#define vsib64_id x64w_vsib64_id
+#define vsib64_bid x64w_vsib64_bid
 #define gpr8_compatible_rr x64w_gpr8_compatible_rr
 #define gpr8_compatible_rm x64w_gpr8_compatible_rm
-#define push_i8  x64w_push_i8 
-#define push_i32 x64w_push_i32
-#define push_r16 x64w_push_r16
-#define push_r64 x64w_push_r64
-#define push_m16 x64w_push_m16
-#define push_m64 x64w_push_m64
-#define pop_r16 x64w_pop_r16
-#define pop_r64 x64w_pop_r64
-#define pop_m16 x64w_pop_m16
-#define pop_m64 x64w_pop_m64
-#define mov_ri8  x64w_mov_ri8 
-#define mov_ri16 x64w_mov_ri16
-#define mov_ri32 x64w_mov_ri32
-#define mov_ri64 x64w_mov_ri64
-#define mov_rr8  x64w_mov_rr8
-#define mov_rr16 x64w_mov_rr16
-#define mov_rr32 x64w_mov_rr32
-#define mov_rr64 x64w_mov_rr64
-#define mov_rm8  x64w_mov_rm8 
-#define mov_rm16 x64w_mov_rm16
-#define mov_rm32 x64w_mov_rm32
-#define mov_rm64 x64w_mov_rm64
-#define mov_mi8  x64w_mov_mi8 
-#define mov_mi16 x64w_mov_mi16
-#define mov_mi32 x64w_mov_mi32
-#define mov_m64i32 x64w_mov_m64i32
-#define mov_mr8  x64w_mov_mr8 
-#define mov_mr16 x64w_mov_mr16
-#define mov_mr32 x64w_mov_mr32
-#define mov_mr64 x64w_mov_mr64
-#define adcx_rr32 x64w_adcx_rr32
-#define adcx_rr64 x64w_adcx_rr64
-#define addpd_xx  x64w_addpd_xx
-#define addpd_xm  x64w_addpd_xm
-#define vaddpd_xxx x64w_vaddpd_xxx
-#define vaddpd_xxm x64w_vaddpd_xxm
-#define vaddpd_yyy x64w_vaddpd_yyy
-#define vaddpd_yym x64w_vaddpd_yym
-#define vaddpd_zzz x64w_vaddpd_zzz
-#define vaddpd_zzm x64w_vaddpd_zzm
+#if X64W_FORMS
+#define operand_r x64w_operand_r
+#define operand_m x64w_operand_m
+#define operand_v x64w_operand_v
+#define operand_i x64w_operand_i
+#define encode x64w_encode
+#define form_info x64w_form_info
+#endif // X64W_FORMS
+#define nop x64w_nop
+#define align x64w_align
 
 INSERT_FUNCTION_PREFIX_STRIPPERS
 